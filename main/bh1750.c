@@ -7,6 +7,10 @@
 #include "bh1750.h"
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "processamento.h"
+#include "i2cbus.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -15,7 +19,6 @@
 #include "driver/i2c.h"
 
 #define BH1750_ADDR           0x23               // Address do Sensor     
-#define I2C_MASTER_PORT       0                  // Número do mestre
 #define WRITE_BIT             I2C_MASTER_WRITE   // Bit de escrita
 #define READ_BIT              I2C_MASTER_READ    // Bit de leitura
 #define ACK_CHECK_EN          0x1                // ACK Enable
@@ -23,6 +26,9 @@
 #define ACK_VAL               0x0                // ACK Check
 #define NACK_VAL              0x1                // NACK Enable
 
+static uint8_t brutos[2];                        // Última leitura (MSB, LSB)
+static bool presente = false;                    // Sensor respondeu à inicialização
+
 /**
  * @brief Escrita I2C
  * 
@@ -38,7 +44,7 @@ static esp_err_t i2c_write_bh1750(uint8_t data)
    i2c_master_write_byte(cmd, BH1750_ADDR << 1 | WRITE_BIT, ACK_CHECK_EN);
    i2c_master_write_byte(cmd, data, ACK_CHECK_EN);
    i2c_master_stop(cmd);
-   ret = i2c_master_cmd_begin(I2C_MASTER_PORT, cmd, 1000 / portTICK_RATE_MS);
+   ret = i2cbus_executa(cmd);
    i2c_cmd_link_delete(cmd);
    return ret;
 }
@@ -59,7 +65,7 @@ static esp_err_t i2c_read_bh1750(uint8_t *lux_msb, uint8_t *lux_lsb)
    i2c_master_read_byte(cmd, lux_msb, ACK_VAL);
    i2c_master_read_byte(cmd, lux_lsb, NACK_VAL);
    i2c_master_stop(cmd);
-   ret = i2c_master_cmd_begin(I2C_MASTER_PORT, cmd, 1000 / portTICK_RATE_MS);
+   ret = i2cbus_executa(cmd);
    i2c_cmd_link_delete(cmd);
    return ret;
 }
@@ -69,11 +75,17 @@ static esp_err_t i2c_read_bh1750(uint8_t *lux_msb, uint8_t *lux_lsb)
  * 
  * Escrever (Power Down) > Escrever (Start)
  * 
+ * @return ESP_OK se o sensor respondeu
  */
-void bh1750_start(void)
+esp_err_t bh1750_start(void)
 {
-   i2c_write_bh1750(0x00);
-   i2c_write_bh1750(0x01);
+   esp_err_t ret = i2c_write_bh1750(0x00);
+   if (ret == ESP_OK)
+   {
+      ret = i2c_write_bh1750(0x01);
+   }
+   presente = (ret == ESP_OK);
+   return ret;
 }
 
 /**
@@ -82,13 +94,41 @@ void bh1750_start(void)
  * Escrever (Start) > Escrever(One Time HRes Mode) > Ler Iluminância
  * 
  * @param lux valor de iluminancia
+ * 
+ * @return ESP_OK se a leitura é válida; em erro, lux não é alterado
  */
-void bh1750_read(float *lux)
+esp_err_t bh1750_read(float *lux)
 {
-   uint8_t lux_msb, lux_lsb;
-   i2c_write_bh1750(0b00000001);
-   i2c_write_bh1750(0b00100000);
+   esp_err_t ret;
+   if (!presente && bh1750_start() != ESP_OK)
+   {
+      // Sensor ausente: tenta de novo na próxima leitura
+      return ESP_ERR_NOT_FOUND;
+   }
+   if ((ret = i2c_write_bh1750(0b00000001)) != ESP_OK ||
+       (ret = i2c_write_bh1750(0b00100000)) != ESP_OK)
+   {
+      presente = false;
+      return ret;
+   }
    vTaskDelay(120 / portTICK_RATE_MS);
-   i2c_read_bh1750(&lux_msb, &lux_lsb);
-   *lux = ((lux_msb << 8 | lux_lsb)/1.2);
+   ret = i2c_read_bh1750(&brutos[0], &brutos[1]);
+   if (ret != ESP_OK)
+   {
+      presente = false;
+      return ret;
+   }
+   *lux = processamento_lux(brutos[0], brutos[1]);
+   return ESP_OK;
+}
+
+/**
+ * @brief Bytes brutos da última leitura
+ * 
+ * @param buf destino (MSB, LSB)
+ */
+void bh1750_brutos(uint8_t buf[2])
+{
+   buf[0] = brutos[0];
+   buf[1] = brutos[1];
 }
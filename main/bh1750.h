@@ -1,16 +1,31 @@
 #ifndef BH1750_H
 #define BH1750_H
 
+#include <stdint.h>
+
+#include "esp_err.h"
+
 /**
- * @brief Inicia o sensor BH1750
+ * @brief Inicia o sensor BH1750. O driver I2C deve estar instalado (i2cbus_start).
+ *
+ * @return ESP_OK se o sensor respondeu; se não, bh1750_read tenta de novo.
  */
-void bh1750_start();
+esp_err_t bh1750_start();
 
 /**
  * @brief Leitura do sensor BH1750
  *
  * @param lux valor de luminância
+ *
+ * @return ESP_OK se a leitura é válida; em erro, lux não é alterado.
+ */
+esp_err_t bh1750_read(float *lux);
+
+/**
+ * @brief Bytes brutos da última leitura, para captura de traces.
+ *
+ * @param buf destino (MSB, LSB)
  */
-void bh1750_read(float *lux);
+void bh1750_brutos(uint8_t buf[2]);
 
 #endif
\ No newline at end of file
@@ -3,10 +3,15 @@
 
 #include <stdint.h>
 
+#include "esp_err.h"
+#include "processamento.h"
+
 /**
- * @brief Inicialização do Sensor BME280
+ * @brief Inicialização do Sensor BME280. O driver I2C deve estar instalado (i2cbus_start).
+ * 
+ * @return ESP_OK se o sensor respondeu; se não, bme280_read tenta detectá-lo de novo.
  */
-void bme280_start();
+esp_err_t bme280_start();
 
 /**
  * @brief Função para ler o sensor BME280.
@@ -14,8 +19,32 @@ void bme280_start();
  * @param temp ponteiro da variável de temperatura.
  * @param pabs ponteiro da variável de pressão.
  * @param umid ponteiro da variável de umidade.
- * @param alt ponteiro da variável de altitude.
+ * 
+ * @return ESP_OK se a leitura é válida; em erro, os valores não são alterados.
+ */
+esp_err_t bme280_read(float *temp, float *pabs, float *umid);
+
+/**
+ * @brief Registradores brutos (0xF7..0xFE) da última leitura, para captura de traces.
+ * 
+ * @param buf destino dos bytes.
+ */
+void bme280_brutos(uint8_t buf[BME280_TAM_DADOS]);
+
+/**
+ * @brief Blocos brutos da última calibração lida, para captura de traces.
+ * 
+ * @param cal1 destino do bloco 0x88..0xA1.
+ * @param cal2 destino do bloco 0xE1..0xE7.
+ */
+void bme280_calibracao_bruta(uint8_t cal1[BME280_TAM_CALIB1], uint8_t cal2[BME280_TAM_CALIB2]);
+
+/**
+ * @brief Quantas vezes a calibração foi lida (0 se o sensor nunca respondeu). Muda quando
+ * o sensor é reconfigurado ao voltar ao barramento.
+ * 
+ * @return contador de leituras da calibração.
  */
-void bme280_read(float *temp, float *pabs, float *umid);
+uint32_t bme280_calibracao_versao();
 
 #endif
\ No newline at end of file
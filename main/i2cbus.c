@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "i2cbus.h"
+
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "driver/i2c.h"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+
+#include "logbuf.h"
+
+#define I2C_MASTER_FREQ_HZ    100000             // Frequência do Mestre 
+#define I2C_SDA               CONFIG_SDA_PIN
+#define I2C_SCL               CONFIG_SCL_PIN
+#define I2C_TIMEOUT_MS        CONFIG_I2C_TIMEOUT_MS
+#define PULSOS_RECUPERACAO    9                  // Pior caso: escravo no meio de um byte + ACK
+#define MEIO_PERIODO_US       5                  // 100 kHz
+
+static uint32_t recuperacoes = 0;
+
+/** 
+ * @brief Instalação do Driver I2C
+ *
+ */
+esp_err_t i2cbus_start(void)
+{
+   i2c_config_t conf;
+   conf.mode = I2C_MODE_MASTER;
+   conf.sda_io_num = I2C_SDA;
+   conf.sda_pullup_en = GPIO_PULLUP_ENABLE;
+   conf.scl_io_num = I2C_SCL;
+   conf.scl_pullup_en = GPIO_PULLUP_ENABLE;
+   conf.master.clk_speed = I2C_MASTER_FREQ_HZ;
+   conf.clk_flags = 0;
+   esp_err_t err = i2c_param_config(I2C_MASTER_PORT, &conf);
+   if (err != ESP_OK)
+   {             
+      return err;
+   }
+   return i2c_driver_install(I2C_MASTER_PORT, conf.mode, 0, 0, 0);
+}
+
+/**
+ * @brief Transação com prazo curto e recuperação em caso de barramento travado.
+ * 
+ */
+esp_err_t i2cbus_executa(i2c_cmd_handle_t cmd)
+{
+   esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_PORT, cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
+   if (ret == ESP_ERR_TIMEOUT || ret == ESP_ERR_INVALID_STATE)
+   {
+      i2cbus_recupera();
+   }
+   return ret;
+}
+
+/**
+ * @brief Recuperação do barramento (NXP UM10204, seção 3.1.16).
+ * 
+ */
+esp_err_t i2cbus_recupera(void)
+{
+   recuperacoes++;
+   LOGB(LOGBUF_MOD_SENSORES, LOGBUF_AVISO, LOG_I2C_RECUPERACAO, recuperacoes);
+   i2c_driver_delete(I2C_MASTER_PORT);
+
+   gpio_set_direction(I2C_SDA, GPIO_MODE_INPUT_OUTPUT_OD);
+   gpio_set_direction(I2C_SCL, GPIO_MODE_INPUT_OUTPUT_OD);
+   gpio_set_pull_mode(I2C_SDA, GPIO_PULLUP_ONLY);
+   gpio_set_pull_mode(I2C_SCL, GPIO_PULLUP_ONLY);
+   gpio_set_level(I2C_SDA, 1);
+   gpio_set_level(I2C_SCL, 1);
+
+   // Pulsos em SCL até o escravo terminar o byte pendente e soltar SDA
+   for (int i = 0; i < PULSOS_RECUPERACAO && gpio_get_level(I2C_SDA) == 0; i++)
+   {
+      gpio_set_level(I2C_SCL, 0);
+      esp_rom_delay_us(MEIO_PERIODO_US);
+      gpio_set_level(I2C_SCL, 1);
+      esp_rom_delay_us(MEIO_PERIODO_US);
+   }
+
+   // STOP: SDA sobe com SCL em nível alto
+   gpio_set_level(I2C_SCL, 0);
+   esp_rom_delay_us(MEIO_PERIODO_US);
+   gpio_set_level(I2C_SDA, 0);
+   esp_rom_delay_us(MEIO_PERIODO_US);
+   gpio_set_level(I2C_SCL, 1);
+   esp_rom_delay_us(MEIO_PERIODO_US);
+   gpio_set_level(I2C_SDA, 1);
+   esp_rom_delay_us(MEIO_PERIODO_US);
+
+   return i2cbus_start();
+}
+
+/**
+ * @brief Recuperações desde o boot.
+ * 
+ */
+uint32_t i2cbus_recuperacoes(void)
+{
+   return recuperacoes;
+}
@@ -0,0 +1,37 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "driver/i2c.h"
+
+#define I2C_MASTER_PORT 0                // Número do mestre, compartilhado por BME280 e BH1750
+
+/**
+ * @brief Instalação do driver I2C nos pinos configurados no KCONFIG.
+ */
+esp_err_t i2cbus_start(void);
+
+/**
+ * @brief Executa uma transação com o prazo curto configurado (CONFIG_I2C_TIMEOUT_MS).
+ *
+ * Se a transação expirar (barramento travado), executa a recuperação do barramento
+ * antes de retornar o erro.
+ *
+ * @param cmd lista de comandos montada com i2c_cmd_link_create
+ */
+esp_err_t i2cbus_executa(i2c_cmd_handle_t cmd);
+
+/**
+ * @brief Recuperação do barramento: desinstala o driver, gera pulsos em SCL até o escravo
+ * soltar SDA, gera um STOP e reinstala o driver.
+ */
+esp_err_t i2cbus_recupera(void);
+
+/**
+ * @brief Quantidade de recuperações do barramento desde o boot.
+ */
+uint32_t i2cbus_recuperacoes(void);
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "jitter.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+static const int32_t limites_us[JITTER_FAIXAS - 1] = { 10, 50, 100, 250, 500, 1000, 5000 };
+
+/**
+ * @brief Zera a estatística.
+ * 
+ */
+void jitter_inicia(jitter_t *j)
+{
+   memset(j, 0, sizeof(*j));
+   j->anterior_us = -1;
+   j->desvio_min_us = INT32_MAX;
+   j->desvio_max_us = INT32_MIN;
+}
+
+/**
+ * @brief Registra uma captura e classifica o desvio do período.
+ * 
+ */
+void jitter_registra(jitter_t *j, int64_t instante_us, int64_t esperado_us)
+{
+   int64_t anterior = j->anterior_us;
+   j->anterior_us = instante_us;
+   if (anterior < 0)
+   {
+      return;
+   }
+
+   int32_t desvio = (int32_t)(instante_us - anterior - esperado_us);
+   int32_t modulo = desvio < 0 ? -desvio : desvio;
+   int faixa = 0;
+   while (faixa < JITTER_FAIXAS - 1 && modulo > limites_us[faixa])
+   {
+      faixa++;
+   }
+   j->faixas[faixa]++;
+   j->periodos++;
+   j->soma_us += desvio;
+   j->soma_quad_us += (int64_t)desvio * desvio;
+   if (desvio < j->desvio_min_us)
+   {
+      j->desvio_min_us = desvio;
+   }
+   if (desvio > j->desvio_max_us)
+   {
+      j->desvio_max_us = desvio;
+   }
+}
+
+/**
+ * @brief Percentil pelo histograma acumulado.
+ * 
+ */
+int32_t jitter_percentil(const jitter_t *j, int percentil)
+{
+   uint64_t alvo = ((uint64_t)j->periodos * percentil + 99) / 100;
+   uint64_t acumulado = 0;
+   for (int i = 0; i < JITTER_FAIXAS - 1; i++)
+   {
+      acumulado += j->faixas[i];
+      if (acumulado >= alvo)
+      {
+         return limites_us[i];
+      }
+   }
+   return -1;
+}
+
+/**
+ * @brief Resumo em uma linha.
+ * 
+ */
+int jitter_relatorio(const jitter_t *j, char *destino, size_t tamanho)
+{
+   if (j->periodos == 0)
+   {
+      return snprintf(destino, tamanho, "periodos=0");
+   }
+   double media = (double)j->soma_us / j->periodos;
+   double variancia = (double)j->soma_quad_us / j->periodos - media * media;
+   int32_t p99 = jitter_percentil(j, 99);
+   int n = snprintf(destino, tamanho, "periodos=%u media=%.1fus dp=%.1fus min=%dus max=%dus p99%s%dus faixas=",
+                    (unsigned)j->periodos, media, sqrt(variancia > 0 ? variancia : 0),
+                    (int)j->desvio_min_us, (int)j->desvio_max_us,
+                    p99 < 0 ? ">" : "<=", (int)(p99 < 0 ? limites_us[JITTER_FAIXAS - 2] : p99));
+   for (int i = 0; i < JITTER_FAIXAS && n >= 0 && (size_t)n < tamanho; i++)
+   {
+      n += snprintf(destino + n, tamanho - n, i == 0 ? "%u" : "/%u", (unsigned)j->faixas[i]);
+   }
+   return n;
+}
@@ -0,0 +1,58 @@
+#ifndef JITTER_H
+#define JITTER_H
+
+/**
+ * @brief Estatística do período entre capturas de amostras (jitter de período).
+ *
+ * Cada captura é comparada com a anterior e o desvio em relação ao período
+ * esperado entra num histograma de faixas fixas. Não depende do ESP-IDF, para
+ * rodar também no host (tools/jitter).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JITTER_FAIXAS 8                   // Limites em jitter.c: 10, 50, 100, 250, 500, 1000, 5000 us e acima
+
+typedef struct {
+   int64_t anterior_us;                   // Última captura, -1 antes da primeira
+   uint32_t periodos;                     // Períodos medidos
+   int64_t soma_us;                       // Soma dos desvios (com sinal)
+   int64_t soma_quad_us;                  // Soma dos quadrados dos desvios
+   int32_t desvio_min_us;
+   int32_t desvio_max_us;
+   uint32_t faixas[JITTER_FAIXAS];        // Contagem por |desvio|
+} jitter_t;
+
+/**
+ * @brief Zera a estatística.
+ */
+void jitter_inicia(jitter_t *j);
+
+/**
+ * @brief Registra o instante de uma captura.
+ *
+ * @param j estado
+ * @param instante_us instante da captura (relógio monotônico)
+ * @param esperado_us período programado desde a captura anterior
+ */
+void jitter_registra(jitter_t *j, int64_t instante_us, int64_t esperado_us);
+
+/**
+ * @brief Limite superior (us) da faixa que contém o percentil pedido do |desvio|.
+ *
+ * @param percentil de 1 a 100
+ *
+ * @return limite da faixa, ou -1 se acima da última faixa limitada
+ */
+int32_t jitter_percentil(const jitter_t *j, int percentil);
+
+/**
+ * @brief Resumo em uma linha: períodos, média, desvio padrão, mínimo, máximo,
+ * p99 e o histograma.
+ *
+ * @return tamanho escrito (como snprintf)
+ */
+int jitter_relatorio(const jitter_t *j, char *destino, size_t tamanho);
+
+#endif
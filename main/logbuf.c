@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "logbuf.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#define NUM_REGISTROS CONFIG_LOGBUF_REGISTROS
+#define PERIODO_TASK_MS 200
+
+/**
+ * @brief Registro binário: 24 bytes, sem nenhuma string.
+ */
+typedef struct {
+    uint32_t tempo_ms;
+    uint16_t formato;
+    uint8_t modulo;
+    uint8_t nivel_nargs;               // nível nos 4 bits altos, quantidade de argumentos nos baixos
+    uint32_t args[LOGBUF_MAX_ARGS];
+} logbuf_registro_t;
+
+#define LOGBUF_TEXTO(id, fmt) fmt,
+static const char *const formatos[LOGBUF_NUM_FORMATOS] = {
+    LOGBUF_FORMATOS(LOGBUF_TEXTO)
+};
+#undef LOGBUF_TEXTO
+
+static const char *const nomes_modulos[LOGBUF_NUM_MODULOS] = { "MAIN", "MQTT", "SENSORES", "TEMPESTADE" };
+static const char letras_niveis[] = { 'N', 'E', 'W', 'I', 'D' };
+
+static logbuf_registro_t registros[NUM_REGISTROS];
+static uint32_t escrita = 0;           // Número de sequência do próximo registro
+static uint32_t leitura = 0;           // Próximo registro a ser formatado pela task
+static uint32_t perdidos = 0;
+static uint8_t niveis[LOGBUF_NUM_MODULOS];
+static portMUX_TYPE logbuf_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Copia o registro de número de sequência seq, se ele ainda estiver no buffer.
+ * 
+ * @return false se o registro já foi sobrescrito ou ainda não foi escrito
+ */
+static bool copia_registro(uint32_t seq, logbuf_registro_t *reg)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&logbuf_mux);
+    if (escrita - seq <= NUM_REGISTROS && seq != escrita)
+    {
+        *reg = registros[seq % NUM_REGISTROS];
+        ok = true;
+    }
+    portEXIT_CRITICAL(&logbuf_mux);
+    return ok;
+}
+
+/**
+ * @brief Formata um registro em texto, interpretando cada argumento pela sua conversão no formato.
+ * 
+ * @param reg registro binário
+ * @param saida buffer de saída
+ * @param tamanho tamanho do buffer de saída
+ */
+static void formata_registro(const logbuf_registro_t *reg, char *saida, size_t tamanho)
+{
+    const char *fmt = reg->formato < LOGBUF_NUM_FORMATOS ? formatos[reg->formato] : "formato desconhecido %u";
+    size_t nargs = reg->nivel_nargs & 0x0F;
+    size_t arg = 0, n = 0;
+    char spec[16];
+
+    while (*fmt != '\0' && n + 1 < tamanho)
+    {
+        if (*fmt != '%' || fmt[1] == '%')
+        {
+            saida[n++] = *fmt;
+            fmt += (*fmt == '%') ? 2 : 1;
+            continue;
+        }
+        // Isola a especificação de conversão (ex.: "%.2f") para formatar um argumento por vez
+        size_t len = 1;
+        while (fmt[len] != '\0' && strchr("diuxXfeg", fmt[len]) == NULL && len < sizeof(spec) - 2)
+        {
+            len++;
+        }
+        memcpy(spec, fmt, len + 1);
+        spec[len + 1] = '\0';
+        uint32_t valor = arg < nargs ? reg->args[arg] : 0;
+        arg++;
+        int escritos;
+        switch (fmt[len])
+        {
+            case 'f': case 'e': case 'g':
+            {
+                union { uint32_t u; float f; } conv = { .u = valor };
+                escritos = snprintf(saida + n, tamanho - n, spec, (double)conv.f);
+                break;
+            }
+            case 'd': case 'i':
+                escritos = snprintf(saida + n, tamanho - n, spec, (int)(int32_t)valor);
+                break;
+            default:
+                escritos = snprintf(saida + n, tamanho - n, spec, (unsigned)valor);
+                break;
+        }
+        if (escritos > 0)
+        {
+            n += ((size_t)escritos < tamanho - n) ? (size_t)escritos : tamanho - n - 1;
+        }
+        fmt += (fmt[len] != '\0') ? len + 1 : len;
+    }
+    saida[n] = '\0';
+}
+
+/**
+ * @brief Imprime um registro já formatado no estilo do ESP_LOG.
+ */
+static void imprime_registro(const logbuf_registro_t *reg)
+{
+    char texto[128];
+    uint8_t nivel = reg->nivel_nargs >> 4;
+    formata_registro(reg, texto, sizeof(texto));
+    printf("%c (%u) %s: %s\n", nivel <= LOGBUF_DEBUG ? letras_niveis[nivel] : '?', (unsigned)reg->tempo_ms,
+           reg->modulo < LOGBUF_NUM_MODULOS ? nomes_modulos[reg->modulo] : "?", texto);
+}
+
+#if CONFIG_LOGBUF_TASK
+/**
+ * @brief Task de baixa prioridade que formata os registros novos.
+ */
+static void logbuf_task(void *param)
+{
+    logbuf_registro_t reg;
+    while (1)
+    {
+        vTaskDelay(PERIODO_TASK_MS / portTICK_RATE_MS);
+        while (1)
+        {
+            portENTER_CRITICAL(&logbuf_mux);
+            if (escrita - leitura > NUM_REGISTROS)
+            {
+                // O escritor deu a volta no buffer antes da task formatar
+                perdidos += escrita - leitura - NUM_REGISTROS;
+                leitura = escrita - NUM_REGISTROS;
+            }
+            portEXIT_CRITICAL(&logbuf_mux);
+            if (!copia_registro(leitura, &reg))
+            {
+                break;
+            }
+            leitura++;
+            imprime_registro(&reg);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Inicia o buffer de log e a task de formatação.
+ * 
+ */
+void logbuf_start(void)
+{
+    for (int i = 0; i < LOGBUF_NUM_MODULOS; i++)
+    {
+        niveis[i] = CONFIG_LOGBUF_NIVEL_PADRAO;
+    }
+#if CONFIG_LOGBUF_TASK
+    xTaskCreatePinnedToCore(&logbuf_task, "logbuf", 3072, NULL, tskIDLE_PRIORITY + 1, NULL, CONFIG_TAREFA_REDE_NUCLEO);
+#endif
+}
+
+/**
+ * @brief Copia um registro para o buffer circular.
+ * 
+ */
+void logbuf_registra(logbuf_modulo_t modulo, logbuf_nivel_t nivel, logbuf_formato_t formato, const uint32_t *args, size_t nargs)
+{
+    if (modulo >= LOGBUF_NUM_MODULOS || nivel > niveis[modulo] || nivel == LOGBUF_NENHUM)
+    {
+        return;
+    }
+    if (nargs > LOGBUF_MAX_ARGS)
+    {
+        nargs = LOGBUF_MAX_ARGS;
+    }
+
+    uint32_t tempo_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    portENTER_CRITICAL(&logbuf_mux);
+    logbuf_registro_t *reg = &registros[escrita % NUM_REGISTROS];
+    reg->tempo_ms = tempo_ms;
+    reg->formato = formato;
+    reg->modulo = modulo;
+    reg->nivel_nargs = (nivel << 4) | nargs;
+    memcpy(reg->args, args, nargs * sizeof(uint32_t));
+    escrita++;
+    portEXIT_CRITICAL(&logbuf_mux);
+}
+
+/**
+ * @brief Ajusta o nível de log de um módulo.
+ * 
+ */
+void logbuf_nivel(logbuf_modulo_t modulo, logbuf_nivel_t nivel)
+{
+    if (modulo < LOGBUF_NUM_MODULOS)
+    {
+        niveis[modulo] = nivel;
+    }
+}
+
+/**
+ * @brief Formata e imprime todo o histórico presente no buffer.
+ * 
+ */
+void logbuf_imprime_historico(void)
+{
+    logbuf_registro_t reg;
+    uint32_t fim = escrita;
+    uint32_t seq = fim > NUM_REGISTROS ? fim - NUM_REGISTROS : 0;
+    for (; seq != fim; seq++)
+    {
+        if (copia_registro(seq, &reg))
+        {
+            imprime_registro(&reg);
+        }
+    }
+}
+
+/**
+ * @brief Registros sobrescritos antes de serem formatados.
+ * 
+ */
+uint32_t logbuf_perdidos(void)
+{
+    return perdidos;
+}
@@ -0,0 +1,120 @@
+#ifndef LOGBUF_H
+#define LOGBUF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Tabela de formatos do log binário.
+ *
+ * Cada registro guarda apenas o ID do formato e até LOGBUF_MAX_ARGS argumentos de 32 bits;
+ * a string só é formatada depois, fora da task de amostragem. Conversões suportadas:
+ * %d/%i (int32), %u/%x/%X (uint32) e %f/%e/%g (float). Não suporta %s.
+ */
+#define LOGBUF_FORMATOS(X) \
+    X(LOG_TEMPERATURA,          "Temperatura: %.2f") \
+    X(LOG_PRESSAO,              "Pressão: %.2f") \
+    X(LOG_UMIDADE,              "Umidade: %.2f") \
+    X(LOG_LUX,                  "Lux: %.2f") \
+    X(LOG_CHUVA,                "Rain: %.0f") \
+    X(LOG_CICLO_OK,             "Ok, ciclo %u") \
+    X(LOG_BME280_FALHA,         "Leitura invalida do BME280, erro 0x%x") \
+    X(LOG_BH1750_FALHA,         "Leitura invalida do BH1750, erro 0x%x") \
+    X(LOG_I2C_RECUPERACAO,      "Recuperacao do barramento I2C (%u)") \
+    X(LOG_RAJADA_INICIADA,      "Rajada iniciada, motivo %d") \
+    X(LOG_EVENTO_ENVIADO,       "Evento %u enviado: %u amostras, %u blocos") \
+    X(LOG_MQTT_CONECTADO,       "MQTT_EVENT_CONNECTED, sessao=%d, %u ms") \
+    X(LOG_MQTT_DESCONECTADO,    "MQTT_EVENT_DISCONNECTED") \
+    X(LOG_MQTT_INSCRITO,        "MQTT_EVENT_SUBSCRIBED, msg_id=%d") \
+    X(LOG_MQTT_DESINSCRITO,     "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d") \
+    X(LOG_MQTT_PUBLICADO,       "MQTT_EVENT_PUBLISHED, msg_id=%d") \
+    X(LOG_MQTT_DADOS,           "MQTT_EVENT_DATA, topico=%d bytes, dados=%d bytes") \
+    X(LOG_MQTT_ERRO,            "MQTT_EVENT_ERROR, tipo=%d") \
+    X(LOG_MQTT_OUTRO,           "Other event id:%d")
+
+#define LOGBUF_ENUM(id, fmt) id,
+typedef enum {
+    LOGBUF_FORMATOS(LOGBUF_ENUM)
+    LOGBUF_NUM_FORMATOS
+} logbuf_formato_t;
+#undef LOGBUF_ENUM
+
+/**
+ * @brief Módulos com nível de log ajustável em tempo de execução.
+ */
+typedef enum {
+    LOGBUF_MOD_MAIN,
+    LOGBUF_MOD_MQTT,
+    LOGBUF_MOD_SENSORES,
+    LOGBUF_MOD_TEMPESTADE,
+    LOGBUF_NUM_MODULOS
+} logbuf_modulo_t;
+
+/**
+ * @brief Níveis de log, do mais severo ao mais detalhado.
+ */
+typedef enum {
+    LOGBUF_NENHUM = 0,
+    LOGBUF_ERRO,
+    LOGBUF_AVISO,
+    LOGBUF_INFO,
+    LOGBUF_DEBUG
+} logbuf_nivel_t;
+
+#define LOGBUF_MAX_ARGS 4
+
+/**
+ * @brief Converte um float para a palavra de 32 bits guardada no registro.
+ */
+static inline uint32_t logbuf_f(float valor)
+{
+    union { float f; uint32_t u; } conv = { .f = valor };
+    return conv.u;
+}
+
+/**
+ * @brief Registra uma mensagem no log binário. Os argumentos devem ser palavras de 32 bits:
+ * inteiros diretamente ou floats via logbuf_f().
+ *
+ * Ex.: LOGB(LOGBUF_MOD_MAIN, LOGBUF_INFO, LOG_TEMPERATURA, logbuf_f(temp));
+ */
+#define LOGB(modulo, nivel, formato, ...) \
+    logbuf_registra((modulo), (nivel), (formato), \
+                    (const uint32_t[]){ 0, ##__VA_ARGS__ } + 1, \
+                    sizeof((const uint32_t[]){ 0, ##__VA_ARGS__ }) / sizeof(uint32_t) - 1)
+
+/**
+ * @brief Inicia o buffer de log e, se configurado, a task que formata os registros.
+ */
+void logbuf_start(void);
+
+/**
+ * @brief Copia um registro para o buffer circular. Não formata nada; seguro para o laço de amostragem.
+ *
+ * @param modulo módulo de origem
+ * @param nivel nível da mensagem
+ * @param formato ID do formato (LOGBUF_FORMATOS)
+ * @param args argumentos de 32 bits
+ * @param nargs quantidade de argumentos (no máximo LOGBUF_MAX_ARGS)
+ */
+void logbuf_registra(logbuf_modulo_t modulo, logbuf_nivel_t nivel, logbuf_formato_t formato, const uint32_t *args, size_t nargs);
+
+/**
+ * @brief Ajusta o nível de log de um módulo em tempo de execução.
+ *
+ * @param modulo módulo a ajustar
+ * @param nivel registros acima deste nível são ignorados
+ */
+void logbuf_nivel(logbuf_modulo_t modulo, logbuf_nivel_t nivel);
+
+/**
+ * @brief Formata e imprime todo o histórico ainda presente no buffer (ex.: para diagnóstico).
+ */
+void logbuf_imprime_historico(void);
+
+/**
+ * @brief Quantidade de registros sobrescritos antes de serem formatados.
+ */
+uint32_t logbuf_perdidos(void);
+
+#endif
@@ -5,10 +5,12 @@
  */
 
 #include <stdio.h>
+#include <math.h>
 
 #include "esp_err.h" 
 #include "nvs_flash.h"
 #include <esp_task_wdt.h>
+#include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -20,51 +22,269 @@
 #include "rainsensor.h"
 #include "wifi.h"
 #include "mqtt.h"
+#include "logbuf.h"
+#include "processamento.h"
+#include "trace.h"
+#include "tempestade.h"
+#include "metricas.h"
+#include "tendencia.h"
+#include "i2cbus.h"
+#include "jitter.h"
+#if CONFIG_JITTER_MEDICAO
+#include <string.h>
+#include <errno.h>
+#include "lwip/sockets.h"
+#include "esp_netif.h"
+#endif
 
 SemaphoreHandle_t conexaoWiFi;
-SemaphoreHandle_t conexaoMQTT;
 
-static void task1(void *param)
+#define PERIODO_PUBLICACAO_MS 60000   // Deve corresponder a TENDENCIA_AMOSTRAS_HORA
+#define ALTITUDE_M CONFIG_ALTITUDE_ESTACAO
+
+static tendencia_t tendencia;
+
+#if CONFIG_JITTER_MEDICAO
+#define CARGA_DESTINO CONFIG_JITTER_CARGA_DESTINO
+#define CARGA_PORTA CONFIG_JITTER_CARGA_PORTA
+#define CARGA_TAMANHO 512
+#define CARGA_CICLO_MS 100
+
+static jitter_t jitter;
+static portMUX_TYPE jitter_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Endereço unicast da carga: CONFIG_JITTER_CARGA_DESTINO ou, vazio, o gateway.
+ *
+ * @return false enquanto o gateway não for conhecido (Wi-Fi sem IP) ou se o destino for inválido
+ */
+static bool destino_carga(struct sockaddr_in *destino)
+{
+    if (CARGA_DESTINO[0] != '\0')
+    {
+        return inet_pton(AF_INET, CARGA_DESTINO, &destino->sin_addr) == 1;
+    }
+    esp_netif_ip_info_t ip;
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (netif == NULL || esp_netif_get_ip_info(netif, &ip) != ESP_OK || ip.gw.addr == 0)
+    {
+        return false;
+    }
+    destino->sin_addr.s_addr = ip.gw.addr;
+    return true;
+}
+
+/**
+ * @brief Carga sintética de rede e relatório da medição de jitter.
+ *
+ * Roda no núcleo de rede: envia datagramas UDP em unicast para o destino configurado
+ * (ou o gateway), ocupando Wi-Fi e lwIP sem passar pela outbox MQTT nem inundar a rede
+ * com broadcast, e imprime periodicamente a distribuição acumulada do desvio do período
+ * de amostragem.
+ */
+static void task_carga(void *param)
 {
+    static char carga[CARGA_TAMANHO];
+    char relatorio[160];
+    jitter_t copia;
+    struct sockaddr_in destino = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CARGA_PORTA),
+    };
+    int sock = -1;
+    bool avisou = false;
+    bool tem_destino = false;
+    uint32_t acumulado = 0;     // Pacotes x 1000 ainda não enviados, para taxas abaixo de 1 por ciclo
+    memset(carga, 'c', sizeof(carga));
+
+    TickType_t despertar = xTaskGetTickCount();
+    int64_t proximo_relatorio = esp_timer_get_time() + (int64_t)CONFIG_JITTER_RELATORIO_S * 1000000;
+    while (1)
+    {
+        if (CONFIG_JITTER_CARGA_PACOTES_S > 0 && !tem_destino)
+        {
+            // O gateway so e conhecido depois que o Wi-Fi recebe IP
+            tem_destino = destino_carga(&destino);
+        }
+        if (tem_destino && sock < 0)
+        {
+            // Sem socket a medicao segue sem carga; tenta de novo no proximo ciclo
+            sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (sock < 0 && !avisou)
+            {
+                printf("jitter: falha ao criar o socket da carga (errno %d), medindo sem carga\n", errno);
+                avisou = true;
+            }
+        }
+        if (sock >= 0)
+        {
+            acumulado += CONFIG_JITTER_CARGA_PACOTES_S * CARGA_CICLO_MS;
+            for (; acumulado >= 1000; acumulado -= 1000)
+            {
+                sendto(sock, carga, sizeof(carga), 0, (struct sockaddr *)&destino, sizeof(destino));
+            }
+        }
+        if (esp_timer_get_time() >= proximo_relatorio)
+        {
+            proximo_relatorio += (int64_t)CONFIG_JITTER_RELATORIO_S * 1000000;
+            portENTER_CRITICAL(&jitter_mux);
+            copia = jitter;
+            portEXIT_CRITICAL(&jitter_mux);
+            jitter_relatorio(&copia, relatorio, sizeof(relatorio));
+            printf("jitter: periodo=%dms carga=%dpps %s\n", CONFIG_JITTER_PERIODO_MS, sock >= 0 ? CONFIG_JITTER_CARGA_PACOTES_S : 0, relatorio);
+        }
+        vTaskDelayUntil(&despertar, pdMS_TO_TICKS(CARGA_CICLO_MS));
+    }
+}
+#endif
+
+/**
+ * @brief Registra e publica uma leitura completa dos sensores.
+ *
+ * Grandezas marcadas como NAN vieram de uma leitura invalida e nao sao
+ * publicadas; o assinante mantem o ultimo valor bom em vez de receber lixo.
+ * Publica no maximo MQTT_MENSAGENS_POR_CICLO mensagens (reserva da outbox no modo tempestade).
+ */
+static void publica_leituras(float temp, float pabs, float umid, float lux, float rain)
+{
+    static uint32_t ciclo = 0;
     char mensagem[50];
+    bool bme_ok = !isnan(temp);
+
+    // Somente registros binarios: a formatacao fica para a task de log
+    if (bme_ok)
+    {
+        LOGB(LOGBUF_MOD_SENSORES, LOGBUF_INFO, LOG_TEMPERATURA, logbuf_f(temp));
+        LOGB(LOGBUF_MOD_SENSORES, LOGBUF_INFO, LOG_PRESSAO, logbuf_f(pabs));
+        LOGB(LOGBUF_MOD_SENSORES, LOGBUF_INFO, LOG_UMIDADE, logbuf_f(umid));
+    }
+    if (!isnan(lux))
+    {
+        LOGB(LOGBUF_MOD_SENSORES, LOGBUF_INFO, LOG_LUX, logbuf_f(lux));
+    }
+    LOGB(LOGBUF_MOD_SENSORES, LOGBUF_INFO, LOG_CHUVA, logbuf_f(rain));
+    LOGB(LOGBUF_MOD_MAIN, LOGBUF_INFO, LOG_CICLO_OK, ciclo++);
+    processamento_formata(mensagem, sizeof(mensagem), rain, 0);
+    mqtt_envia_mensagem("topic/chuva", mensagem);
+    if (bme_ok)
+    {
+        processamento_formata(mensagem, sizeof(mensagem), temp, 2);
+        mqtt_envia_mensagem("topic/temperatura", mensagem);
+        processamento_formata(mensagem, sizeof(mensagem), umid, 2);
+        mqtt_envia_mensagem("topic/umidade", mensagem);
+        processamento_formata(mensagem, sizeof(mensagem), pabs, 2);
+        mqtt_envia_mensagem("topic/pressao", mensagem);
+    }
+    if (!isnan(lux))
+    {
+        processamento_formata(mensagem, sizeof(mensagem), lux, 2);
+        mqtt_envia_mensagem("topic/luminosidade", mensagem);
+    }
+
+    // Tendencia barometrica e previsao local, publicadas quando ha 3 h de historico
+    float inclinacao_3h;
+    if (bme_ok)
+    {
+        tendencia_adiciona(&tendencia, lroundf(pabs * 100));
+    }
+    int codigo = tendencia_codigo_wmo(&tendencia);
+    if (bme_ok && codigo >= 0 && tendencia_inclinacao(&tendencia, 3, &inclinacao_3h))
+    {
+        sprintf(mensagem, "%d", codigo);
+        mqtt_envia_mensagem("topic/tendencia", mensagem);
+        processamento_formata(mensagem, sizeof(mensagem), inclinacao_3h * 3, 2);
+        mqtt_envia_mensagem("topic/tendencia_3h", mensagem);
+        mensagem[0] = tendencia_zambretti(tendencia_nivel_mar(pabs, temp, ALTITUDE_M), inclinacao_3h * 3);
+        mensagem[1] = '\0';
+        mqtt_envia_mensagem("topic/previsao", mensagem);
+    }
+}
+
+static void task1(void *param)
+{
+    esp_err_t erro;
+
+    i2cbus_start();
+    // Sensores ausentes no boot nao impedem a partida: a leitura tenta de novo
     bme280_start();
     bh1750_start();
     rainsensor_start();
+#if CONFIG_TRACE_CAPTURA
+    trace_start();
+#endif
+#if CONFIG_TEMPESTADE
+    tempestade_start();
+#endif
+    tendencia_inicia(&tendencia);
     esp_task_wdt_add(NULL); // Habilita o monitoramento do Task WDT nesta tarefa
     float temp, pabs, umid, lux, rain;
+    TickType_t despertar, proxima_publicacao, espera;
+    uint32_t espera_ms;
+    // Sem esperar o broker (nem o Wi-Fi): o esp-mqtt reconecta sozinho e a outbox limitada
+    // absorve as leituras ate a conexao subir, entao um broker fora do ar nao atrasa a amostragem
+    mqtt_start();
+    // Capturas agendadas em ticks absolutos: o tempo gasto lendo e publicando
+    // nao desloca a captura seguinte
+    despertar = xTaskGetTickCount();
+    proxima_publicacao = despertar;
+    espera = 0;
     while(1)
     {
-        if(xSemaphoreTake(conexaoWiFi, portMAX_DELAY))
+#if CONFIG_JITTER_MEDICAO
+        int64_t captura_us = esp_timer_get_time();
+        portENTER_CRITICAL(&jitter_mux);
+        jitter_registra(&jitter, captura_us, (int64_t)espera * portTICK_PERIOD_MS * 1000);
+        portEXIT_CRITICAL(&jitter_mux);
+#endif
+        erro = bme280_read(&temp, &pabs, &umid);
+        if (erro != ESP_OK)
         {
-            mqtt_start();
+            LOGB(LOGBUF_MOD_SENSORES, LOGBUF_AVISO, LOG_BME280_FALHA, erro);
+            temp = pabs = umid = NAN;
         }
-        if(xSemaphoreTake(conexaoMQTT, portMAX_DELAY))
+        rainsensor_read(&rain);
+        if ((int32_t)(despertar - proxima_publicacao) >= 0)
         {
-            while(1)
+            proxima_publicacao += pdMS_TO_TICKS(PERIODO_PUBLICACAO_MS);
+            erro = bh1750_read(&lux);
+            if (erro != ESP_OK)
+            {
+                LOGB(LOGBUF_MOD_SENSORES, LOGBUF_AVISO, LOG_BH1750_FALHA, erro);
+                lux = NAN;
+            }
+#if CONFIG_TRACE_CAPTURA
+            // Mesma condicao que alimenta a tendencia, para o replay reproduzi-la
+            if (!isnan(temp))
             {
-                bme280_read(&temp, &pabs, &umid);
-                bh1750_read(&lux);
-                rainsensor_read(&rain);
-                printf("Temperatura: %f\n", temp);
-                printf("Pressão: %f\n", pabs);
-                printf("Umidade: %f\n",umid);
-                printf("Lux: %f\n",lux);
-                printf("Rain: %f\n",rain);
-                printf("Ok\n");
-                sprintf(mensagem, "%d", (int)rain);
-                mqtt_envia_mensagem("topic/chuva", mensagem);
-                sprintf(mensagem, "%.2f", (float)temp);
-                mqtt_envia_mensagem("topic/temperatura", mensagem);
-                sprintf(mensagem, "%.2f", (float)umid);
-                mqtt_envia_mensagem("topic/umidade", mensagem);
-                sprintf(mensagem, "%.2f", (float)pabs);
-                mqtt_envia_mensagem("topic/pressao", mensagem);
-                sprintf(mensagem, "%.2f", (float)lux);
-                mqtt_envia_mensagem("topic/luminosidade", mensagem);
-                esp_task_wdt_reset(); // Alimenta o WDT
-                vTaskDelay(60000 / portTICK_RATE_MS);
+                trace_registra_amostra(!isnan(lux));
             }
+#endif
+            publica_leituras(temp, pabs, umid, lux, rain);
         }
+#if CONFIG_JITTER_MEDICAO
+        espera_ms = CONFIG_JITTER_PERIODO_MS;
+#elif CONFIG_TEMPESTADE
+        // Entre publicacoes, o detector de tempestade define o ritmo de amostragem;
+        // numa falha de leitura mantem o ritmo atual, sem descartar a rajada
+        espera_ms = isnan(temp) ? tempestade_periodo_atual() : tempestade_amostra(temp, pabs, umid, rain);
+#else
+        espera_ms = PERIODO_PUBLICACAO_MS;
+#endif
+        espera = pdMS_TO_TICKS(espera_ms);
+        if (proxima_publicacao - despertar < espera)
+        {
+            espera = proxima_publicacao - despertar;
+        }
+        if (espera == 0)
+        {
+            espera = 1;
+        }
+#if CONFIG_METRICAS_HTTP
+        // A cada amostra, inclusive entre publicacoes (tempestade, jitter); lux e da ultima publicacao
+        metricas_atualiza(temp, pabs, umid, lux, rain);
+#endif
+        esp_task_wdt_reset(); // Alimenta o WDT
+        vTaskDelayUntil(&despertar, espera);
     }
 }
 
@@ -81,11 +301,22 @@ void app_main(void)
     }
 
     ESP_ERROR_CHECK(ret);
+
+    logbuf_start();
     
     conexaoWiFi = xSemaphoreCreateBinary();
-    conexaoMQTT = xSemaphoreCreateBinary();
 
     wifi_start();
 
-    xTaskCreate(&task1, "t1", 4096, NULL, 1, NULL);
+#if CONFIG_METRICAS_HTTP
+    metricas_start();
+#endif
+
+#if CONFIG_JITTER_MEDICAO
+    jitter_inicia(&jitter);
+    xTaskCreatePinnedToCore(&task_carga, "carga", 3072, NULL, 5, NULL, CONFIG_TAREFA_REDE_NUCLEO);
+#endif
+
+    // Amostragem no nucleo de aplicacao, acima das tarefas de rede (Kconfig "Configuração de Tarefas")
+    xTaskCreatePinnedToCore(&task1, "t1", 4096, NULL, CONFIG_TAREFA_AMOSTRAGEM_PRIORIDADE, NULL, CONFIG_TAREFA_AMOSTRAGEM_NUCLEO);
 }
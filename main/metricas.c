@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "metricas.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_http_server.h"
+
+#include "mqtt.h"
+#include "processamento.h"
+
+#define TAM_RESPOSTA 2560    // Todas as métricas com valores de 10 dígitos cabem (~1,9 KB)
+
+#define TAG "METRICAS"
+
+/**
+ * @brief Resposta pré-formatada; servida direto do buffer, sem cópia.
+ */
+typedef struct {
+    char texto[TAM_RESPOSTA];
+    size_t tamanho;
+    uint32_t em_uso;     // Requisições enviando este buffer
+} resposta_t;
+
+static resposta_t respostas[2];
+static int ativa = 0;                    // Buffer servido pelas novas requisições
+static uint32_t amostras = 0;
+static portMUX_TYPE metricas_mux = portMUX_INITIALIZER_UNLOCKED;
+static httpd_handle_t servidor = NULL;
+
+/**
+ * @brief GET /metrics: reserva o buffer ativo e envia sem formatar nada.
+ */
+static esp_err_t metricas_get(httpd_req_t *req)
+{
+    portENTER_CRITICAL(&metricas_mux);
+    resposta_t *r = &respostas[ativa];
+    r->em_uso++;
+    portEXIT_CRITICAL(&metricas_mux);
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    esp_err_t ret = httpd_resp_send(req, r->texto, r->tamanho);
+
+    portENTER_CRITICAL(&metricas_mux);
+    r->em_uso--;
+    portEXIT_CRITICAL(&metricas_mux);
+    return ret;
+}
+
+static const httpd_uri_t uri_metricas = {
+    .uri = "/metrics",
+    .method = HTTP_GET,
+    .handler = metricas_get,
+    .user_ctx = NULL
+};
+
+/**
+ * @brief Inicia o servidor HTTP de métricas.
+ * 
+ */
+esp_err_t metricas_start(void)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_METRICAS_PORTA;
+    config.max_uri_handlers = 1;
+    config.lru_purge_enable = true;
+    config.core_id = CONFIG_TAREFA_REDE_NUCLEO;      // Longe da tarefa de amostragem
+
+    respostas[0].tamanho = snprintf(respostas[0].texto, TAM_RESPOSTA, "# sem amostras\n");
+
+    esp_err_t ret = httpd_start(&servidor, &config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao iniciar servidor HTTP: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    return httpd_register_uri_handler(servidor, &uri_metricas);
+}
+
+/**
+ * @brief Acrescenta uma métrica ("# TYPE" e valor) à resposta, somente com cópias.
+ * 
+ * @param r resposta em construção
+ * @param nome nome da métrica
+ * @param tipo gauge ou counter
+ * @param valor valor já formatado
+ */
+static void acrescenta(resposta_t *r, const char *nome, const char *tipo, const char *valor)
+{
+    const char *partes[] = { "# TYPE ", nome, " ", tipo, "\n", nome, " ", valor, "\n" };
+    for (size_t i = 0; i < sizeof(partes) / sizeof(partes[0]); i++)
+    {
+        size_t n = strlen(partes[i]);
+        if (r->tamanho + n >= TAM_RESPOSTA)
+        {
+            return;
+        }
+        memcpy(r->texto + r->tamanho, partes[i], n);
+        r->tamanho += n;
+    }
+}
+
+/**
+ * @brief Gauge de leitura, pelo formatador de ponto fixo; NAN (leitura inválida) vira NaN.
+ * 
+ */
+static void acrescenta_leitura(resposta_t *r, const char *nome, float valor, int casas)
+{
+    char texto[24];
+    if (isnan(valor))
+    {
+        strcpy(texto, "NaN");
+    }
+    else
+    {
+        processamento_formata(texto, sizeof(texto), valor, casas);
+    }
+    acrescenta(r, nome, "gauge", texto);
+}
+
+/**
+ * @brief Contador ou gauge inteiro.
+ * 
+ */
+static void acrescenta_inteiro(resposta_t *r, const char *nome, const char *tipo, uint32_t valor)
+{
+    char texto[16];
+    processamento_formata_fixo(texto, sizeof(texto), (int32_t)valor, 0);
+    acrescenta(r, nome, tipo, texto);
+}
+
+/**
+ * @brief Reconstrói a resposta no buffer inativo.
+ * 
+ * Roda na task de amostragem: sem snprintf de ponto flutuante, como o resto do ciclo.
+ */
+void metricas_atualiza(float temp, float pabs, float umid, float lux, float chuva)
+{
+    mqtt_estatisticas_t est;
+    int inativa;
+
+    amostras++;
+    portENTER_CRITICAL(&metricas_mux);
+    inativa = !ativa;
+    bool livre = respostas[inativa].em_uso == 0;
+    portEXIT_CRITICAL(&metricas_mux);
+    if (!livre)
+    {
+        return;
+    }
+
+    mqtt_estatisticas(&est);
+    resposta_t *r = &respostas[inativa];
+    r->tamanho = 0;
+    acrescenta_leitura(r, "estacao_temperatura_celsius", temp, 2);
+    acrescenta_leitura(r, "estacao_pressao_hpa", pabs, 2);
+    acrescenta_leitura(r, "estacao_umidade_percentual", umid, 2);
+    acrescenta_leitura(r, "estacao_luminosidade_lux", lux, 2);
+    acrescenta_leitura(r, "estacao_chuva", chuva, 0);
+    acrescenta_inteiro(r, "estacao_amostras_total", "counter", amostras);
+    acrescenta_inteiro(r, "estacao_mqtt_enfileiradas_total", "counter", est.enfileiradas);
+    acrescenta_inteiro(r, "estacao_mqtt_descartadas_total", "counter", est.descartadas);
+    acrescenta_inteiro(r, "estacao_mqtt_coalescidas_total", "counter", est.coalescidas);
+    acrescenta_inteiro(r, "estacao_mqtt_publicadas_total", "counter", est.publicadas);
+    acrescenta_inteiro(r, "estacao_mqtt_confirmadas_total", "counter", est.confirmadas);
+    acrescenta_inteiro(r, "estacao_mqtt_retransmissoes_total", "counter", est.retransmissoes);
+    acrescenta_inteiro(r, "estacao_mqtt_expiradas_total", "counter", est.expiradas);
+    acrescenta_inteiro(r, "estacao_mqtt_em_voo", "gauge", est.em_voo);
+    acrescenta_inteiro(r, "estacao_mqtt_latencia_enfileirar_us", "gauge", (uint32_t)est.latencia_enfileirar_us);
+    acrescenta_inteiro(r, "estacao_mqtt_latencia_enfileirar_max_us", "gauge", (uint32_t)est.latencia_enfileirar_max_us);
+    acrescenta_inteiro(r, "estacao_mqtt_conexoes_total", "counter", est.conexoes);
+    acrescenta_inteiro(r, "estacao_mqtt_conexoes_sessao_presente_total", "counter", est.conexoes_sessao_presente);
+    acrescenta_inteiro(r, "estacao_mqtt_tempo_conexao_ms", "gauge", est.tempo_conexao_ms);
+    acrescenta_inteiro(r, "estacao_mqtt_tempo_conexao_max_ms", "gauge", est.tempo_conexao_max_ms);
+    acrescenta_inteiro(r, "estacao_heap_livre_bytes", "gauge", esp_get_free_heap_size());
+    acrescenta_inteiro(r, "estacao_heap_minimo_bytes", "gauge", esp_get_minimum_free_heap_size());
+    acrescenta_inteiro(r, "estacao_uptime_segundos", "counter", (uint32_t)(esp_timer_get_time() / 1000000));
+    r->texto[r->tamanho] = '\0';
+
+    portENTER_CRITICAL(&metricas_mux);
+    ativa = inativa;
+    portEXIT_CRITICAL(&metricas_mux);
+}
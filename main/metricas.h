@@ -0,0 +1,27 @@
+#ifndef METRICAS_H
+#define METRICAS_H
+
+#include "esp_err.h"
+
+/**
+ * @brief Inicia o servidor HTTP que responde GET /metrics no formato texto do Prometheus.
+ * Deve ser chamada depois de wifi_start().
+ */
+esp_err_t metricas_start(void);
+
+/**
+ * @brief Reconstrói a resposta com a última leitura e os contadores atuais. Chamada pela
+ * task de amostragem a cada amostra; estacao_amostras_total conta essas chamadas.
+ *
+ * Escreve no buffer que não está sendo servido e troca os buffers no final; nunca bloqueia.
+ * Se os dois buffers estiverem em uso por requisições lentas, a atualização é pulada.
+ *
+ * @param temp temperatura (°C)
+ * @param pabs pressão (hPa)
+ * @param umid umidade (%)
+ * @param lux iluminância (lx)
+ * @param chuva leitura do sensor de chuva (10 bits)
+ */
+void metricas_atualiza(float temp, float pabs, float umid, float lux, float chuva);
+
+#endif
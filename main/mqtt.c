@@ -5,15 +5,19 @@
  */
 
 #include "mqtt.h"
+#include "logbuf.h"
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_ota_ops.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -26,18 +30,86 @@
 
 #include "esp_log.h"
 #include "mqtt_client.h"
+#if CONFIG_MQTT_TLS_CA_BUNDLE
+#include "esp_crt_bundle.h"
+#endif
 
 #define MQTT_URI CONFIG_URI_MQTT
 #define MQTT_PORT CONFIG_PORT_MQTT
 #define MQTT_CLIENT_ID CONFIG_CLIENT_ID_MQTT
 #define MQTT_USER CONFIG_USERNAME_MQTT
 #define MQTT_PASS CONFIG_PASSWORD_MQTT
+#define MQTT_TOPICO_COMANDO CONFIG_MQTT_TOPICO_COMANDO
+#define MQTT_KEEPALIVE_S CONFIG_MQTT_KEEPALIVE_S
+#define MQTT_TOPICO_STATUS CONFIG_MQTT_TOPICO_STATUS
+#define MQTT_VERSAO_CONFIG CONFIG_MQTT_VERSAO_CONFIG
+#if CONFIG_MQTT_RETER_LEITURAS
+#define RETER_LEITURAS true
+#else
+#define RETER_LEITURAS false
+#endif
+
+#define OUTBOX_TAMANHO CONFIG_MQTT_OUTBOX_LEN
+#define JANELA_QOS1 CONFIG_MQTT_JANELA_QOS1
+#define ACK_TIMEOUT_US ((int64_t)CONFIG_MQTT_ACK_TIMEOUT_MS * 1000)
+#define QOS_PUBLICACAO 1
+#define STATUS_OFFLINE "{\"estado\":\"offline\"}"
+#define STATUS_ONLINE "{\"estado\":\"online\",\"firmware\":\"%.*s\",\"config\":\"%s\"}"
+#define TAM_VERSAO_FIRMWARE sizeof(((esp_app_desc_t *)0)->version)
 
 #define TAG "MQTT"
 
+/**
+ * @brief Mensagem aguardando envio (outbox) ou confirmação (janela QoS1).
+ */
+typedef struct {
+    char topico[MQTT_TOPICO_MAX];
+    char dados[MQTT_MENSAGEM_MAX];
+    int tamanho;
+    bool reter;                         // Broker guarda como último valor do tópico
+} mqtt_item_t;
+
+/**
+ * @brief Posição da janela de mensagens QoS1 em voo.
+ */
+typedef struct {
+    bool ocupado;
+    int msg_id;
+    int64_t enviado_us;                 // Primeira tentativa; reenvios de recusadas não reiniciam o timeout
+    mqtt_item_t item;
+} mqtt_em_voo_t;
+
 esp_mqtt_client_handle_t client;
 
-extern xSemaphoreHandle conexaoMQTT;
+// Outbox circular, protegida por outbox_mutex. Produtores: task de amostragem.
+static mqtt_item_t outbox[OUTBOX_TAMANHO];
+static size_t outbox_inicio = 0;
+static size_t outbox_qtd = 0;
+static SemaphoreHandle_t outbox_mutex = NULL;
+
+// Janela de QoS1, acessada somente pela task de publicação.
+static mqtt_em_voo_t em_voo[JANELA_QOS1];
+
+// IDs confirmados pelo broker (PUBACK), repassados do handler de eventos para a task de publicação.
+static QueueHandle_t fila_acks = NULL;
+static TaskHandle_t task_publicacao = NULL;
+static volatile bool conectado = false;
+
+static mqtt_estatisticas_t estatisticas;
+static mqtt_comando_cb_t comando_cb = NULL;
+static int64_t inicio_conexao_us = 0;
+// Mensagem de nascimento, montada em mqtt_start; cabe a maior versão de firmware e a configuração
+static char status_online[sizeof(STATUS_ONLINE) + TAM_VERSAO_FIRMWARE + sizeof(MQTT_VERSAO_CONFIG)];
+
+#if CONFIG_MQTT_TLS && !CONFIG_MQTT_TLS_CA_BUNDLE
+// Certificado da CA do broker, embutido com EMBED_TXTFILES certs/ca.pem
+extern const char ca_pem_start[] asm("_binary_ca_pem_start");
+#endif
+#if CONFIG_MQTT_TLS_CERT_CLIENTE
+// Certificado e chave do cliente, embutidos com EMBED_TXTFILES certs/client.crt certs/client.key
+extern const char client_crt_start[] asm("_binary_client_crt_start");
+extern const char client_key_start[] asm("_binary_client_key_start");
+#endif
 
 static void log_error_if_nonzero(const char * message, int error_code)
 {
@@ -47,36 +119,78 @@ static void log_error_if_nonzero(const char * message, int error_code)
     }
 }
 
+/**
+ * @brief Contabiliza uma conexão: tempo desde o início da conexão (TCP + TLS + CONNECT/CONNACK)
+ * e se o broker retomou a sessão persistente.
+ * 
+ * @param sessao_presente flag session present do CONNACK
+ */
+static void registra_conexao(int sessao_presente)
+{
+    uint32_t tempo_ms = (uint32_t)((esp_timer_get_time() - inicio_conexao_us) / 1000);
+    estatisticas.conexoes++;
+    if (sessao_presente)
+    {
+        estatisticas.conexoes_sessao_presente++;
+    }
+    estatisticas.tempo_conexao_ms = tempo_ms;
+    if (tempo_ms > estatisticas.tempo_conexao_max_ms)
+    {
+        estatisticas.tempo_conexao_max_ms = tempo_ms;
+    }
+}
+
 static esp_err_t mqtt_event_handler_cb(esp_mqtt_event_handle_t event)
 {
     esp_mqtt_client_handle_t client = event->client;
     // your_context_t *context = event->context;
     switch (event->event_id) 
     {
+        case MQTT_EVENT_BEFORE_CONNECT:
+            inicio_conexao_us = esp_timer_get_time();
+            break;
         case MQTT_EVENT_CONNECTED:
-            ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
-            xSemaphoreGive(conexaoMQTT);
+            registra_conexao(event->session_present);
+            LOGB(LOGBUF_MOD_MQTT, LOGBUF_INFO, LOG_MQTT_CONECTADO, event->session_present, estatisticas.tempo_conexao_ms);
+            conectado = true;
+            xTaskNotifyGive(task_publicacao);
+            // Nascimento: substitui no broker o last will retido da conexão anterior
+            esp_mqtt_client_publish(client, MQTT_TOPICO_STATUS, status_online, 0, QOS_PUBLICACAO, 1);
+            // QoS0: com sessão persistente, um comando QoS1 enviado com a estação offline seria
+            // entregue na reconexão e dispararia uma rajada fora de hora. Assina a cada conexão
+            // para rebaixar também assinaturas QoS1 guardadas pelo broker.
+            esp_mqtt_client_subscribe(client, MQTT_TOPICO_COMANDO, 0);
             break;
         case MQTT_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
+            LOGB(LOGBUF_MOD_MQTT, LOGBUF_AVISO, LOG_MQTT_DESCONECTADO);
+            conectado = false;
             break;
 
         case MQTT_EVENT_SUBSCRIBED:
-            ESP_LOGI(TAG, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
+            LOGB(LOGBUF_MOD_MQTT, LOGBUF_INFO, LOG_MQTT_INSCRITO, event->msg_id);
             break;
         case MQTT_EVENT_UNSUBSCRIBED:
-            ESP_LOGI(TAG, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
+            LOGB(LOGBUF_MOD_MQTT, LOGBUF_INFO, LOG_MQTT_DESINSCRITO, event->msg_id);
             break;
         case MQTT_EVENT_PUBLISHED:
-            ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+            LOGB(LOGBUF_MOD_MQTT, LOGBUF_DEBUG, LOG_MQTT_PUBLICADO, event->msg_id);
+            if (xQueueSend(fila_acks, &event->msg_id, 0) != pdTRUE)
+            {
+                // Fila cheia: a posicao so e liberada quando expirar o timeout de ACK
+                ESP_LOGW(TAG, "Fila de ACKs cheia, msg_id=%d", event->msg_id);
+            }
+            xTaskNotifyGive(task_publicacao);
             break;
         case MQTT_EVENT_DATA:
-            ESP_LOGI(TAG, "MQTT_EVENT_DATA");
-            printf("TOPIC=%.*s\r\n", event->topic_len, event->topic);
-            printf("DATA=%.*s\r\n", event->data_len, event->data);
+            LOGB(LOGBUF_MOD_MQTT, LOGBUF_INFO, LOG_MQTT_DADOS, event->topic_len, event->data_len);
+            if (comando_cb != NULL && event->topic_len == strlen(MQTT_TOPICO_COMANDO) &&
+                strncmp(event->topic, MQTT_TOPICO_COMANDO, event->topic_len) == 0)
+            {
+                comando_cb(event->data, event->data_len);
+            }
             break;
         case MQTT_EVENT_ERROR:
-            ESP_LOGI(TAG, "MQTT_EVENT_ERROR");
+            LOGB(LOGBUF_MOD_MQTT, LOGBUF_ERRO, LOG_MQTT_ERRO, event->error_handle->error_type);
             if (event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT) 
             {
                 log_error_if_nonzero("reported from esp-tls", event->error_handle->esp_tls_last_esp_err);
@@ -86,7 +200,7 @@ static esp_err_t mqtt_event_handler_cb(esp_mqtt_event_handle_t event)
             }
             break;
         default:
-            ESP_LOGI(TAG, "Other event id:%d", event->event_id);
+            LOGB(LOGBUF_MOD_MQTT, LOGBUF_DEBUG, LOG_MQTT_OUTRO, event->event_id);
             break;
     }
     return ESP_OK;
@@ -98,19 +212,179 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     mqtt_event_handler_cb(event_data);
 }
 
+/**
+ * @brief Retira a mensagem mais antiga da outbox.
+ * 
+ * @param item destino da mensagem retirada
+ * 
+ * @return true se havia mensagem na outbox
+ */
+static bool outbox_retira(mqtt_item_t *item)
+{
+    bool ok = false;
+    xSemaphoreTake(outbox_mutex, portMAX_DELAY);
+    if (outbox_qtd > 0)
+    {
+        *item = outbox[outbox_inicio];
+        outbox_inicio = (outbox_inicio + 1) % OUTBOX_TAMANHO;
+        outbox_qtd--;
+        ok = true;
+    }
+    xSemaphoreGive(outbox_mutex);
+    return ok;
+}
+
+/**
+ * @brief Entrega uma posição da janela QoS1 ao cliente MQTT.
+ * 
+ * Uma vez aceita (msg_id >= 0), a mensagem fica na outbox do esp-mqtt, que a
+ * retransmite com DUP mantendo o msg_id; aqui ela nunca é republicada.
+ * 
+ * @param slot posição da janela
+ */
+static void publica_slot(mqtt_em_voo_t *slot)
+{
+    slot->msg_id = esp_mqtt_client_publish(client, slot->item.topico, slot->item.dados, slot->item.tamanho, QOS_PUBLICACAO, slot->item.reter);
+    if (slot->msg_id < 0)
+    {
+        // Recusada pelo cliente (sem conexao ou sem memoria): nenhuma copia ficou no esp-mqtt
+        ESP_LOGW(TAG, "Falha ao publicar em %s", slot->item.topico);
+    }
+}
+
+/**
+ * @brief Libera da janela as mensagens confirmadas pelo broker.
+ */
+static void processa_acks(void)
+{
+    int msg_id;
+    while (xQueueReceive(fila_acks, &msg_id, 0) == pdTRUE)
+    {
+        for (int i = 0; i < JANELA_QOS1; i++)
+        {
+            if (em_voo[i].ocupado && em_voo[i].msg_id == msg_id)
+            {
+                em_voo[i].ocupado = false;
+                estatisticas.em_voo--;
+                estatisticas.confirmadas++;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Libera da janela as posições que expiraram e reenvia as recusadas pelo cliente.
+ * 
+ * A retransmissão de mensagens aceitas fica a cargo do esp-mqtt. Passado o timeout,
+ * o esp-mqtt já descartou a mensagem da sua outbox e o PUBACK não virá mais. O mesmo
+ * timeout vale para as recusadas, para que recusas seguidas não prendam a janela.
+ */
+static void verifica_pendentes(void)
+{
+    int64_t agora = esp_timer_get_time();
+    for (int i = 0; i < JANELA_QOS1; i++)
+    {
+        if (!em_voo[i].ocupado)
+        {
+            continue;
+        }
+        if (agora - em_voo[i].enviado_us >= ACK_TIMEOUT_US)
+        {
+            em_voo[i].ocupado = false;
+            estatisticas.em_voo--;
+            estatisticas.expiradas++;
+        }
+        else if (em_voo[i].msg_id < 0)
+        {
+            publica_slot(&em_voo[i]);
+            estatisticas.retransmissoes++;
+        }
+    }
+}
+
+/**
+ * @brief Task dona da transmissão: esvazia a outbox respeitando a janela de QoS1.
+ * 
+ * A task de amostragem nunca chama o cliente MQTT diretamente, então um broker
+ * lento ou uma conexão TCP travada bloqueia somente esta task.
+ */
+static void mqtt_task_publicacao(void *param)
+{
+    mqtt_item_t item;
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        processa_acks();
+        if (!conectado)
+        {
+            continue;
+        }
+        verifica_pendentes();
+        for (int i = 0; i < JANELA_QOS1 && conectado; i++)
+        {
+            if (em_voo[i].ocupado)
+            {
+                continue;
+            }
+            if (!outbox_retira(&item))
+            {
+                break;
+            }
+            em_voo[i].item = item;
+            em_voo[i].ocupado = true;
+            em_voo[i].enviado_us = esp_timer_get_time();
+            estatisticas.em_voo++;
+            publica_slot(&em_voo[i]);
+            estatisticas.publicadas++;
+        }
+    }
+}
+
 /**
  * @brief Configura MQTT e inicia comunicação.
  * 
  */
 void mqtt_start()
 {
+    const esp_app_desc_t *app = esp_ota_get_app_description();
+    snprintf(status_online, sizeof(status_online), STATUS_ONLINE, (int)TAM_VERSAO_FIRMWARE, app->version, MQTT_VERSAO_CONFIG);
+
     esp_mqtt_client_config_t mqtt_config = {
         .uri = MQTT_URI,
         .port = MQTT_PORT,
         .client_id = MQTT_CLIENT_ID,
         .username = MQTT_USER,
         .password = MQTT_PASS,
+        .keepalive = MQTT_KEEPALIVE_S,
+        // Last will: o broker publica offline retido só se a conexão cair sem DISCONNECT; num
+        // DISCONNECT normal o will é descartado, então uma desconexão proposital (hoje não há
+        // nenhuma) deve publicar STATUS_OFFLINE antes
+        .lwt_topic = MQTT_TOPICO_STATUS,
+        .lwt_msg = STATUS_OFFLINE,
+        .lwt_qos = QOS_PUBLICACAO,
+        .lwt_retain = 1,
+#if CONFIG_MQTT_SESSAO_PERSISTENTE
+        // O broker guarda assinaturas e mensagens QoS1 entre reconexões (requer client_id fixo)
+        .disable_clean_session = true,
+#endif
+#if CONFIG_MQTT_TLS_CA_BUNDLE
+        .crt_bundle_attach = esp_crt_bundle_attach,
+#elif CONFIG_MQTT_TLS
+        .cert_pem = ca_pem_start,
+#endif
+#if CONFIG_MQTT_TLS_CERT_CLIENTE
+        .client_cert_pem = client_crt_start,
+        .client_key_pem = client_key_start,
+#endif
     };
+
+    if (task_publicacao == NULL)
+    {
+        outbox_mutex = xSemaphoreCreateMutex();
+        fila_acks = xQueueCreate(2 * JANELA_QOS1, sizeof(int));
+        xTaskCreatePinnedToCore(&mqtt_task_publicacao, "mqtt_pub", 4096, NULL, 5, &task_publicacao, CONFIG_TAREFA_REDE_NUCLEO);
+    }
     
     client = esp_mqtt_client_init(&mqtt_config);
     esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, client);
@@ -118,11 +392,141 @@ void mqtt_start()
 }
 
 /**
- * @brief Faz o envio de uma mensagem via MQTT
+ * @brief Insere na outbox, aplicando a política de transbordo configurada. Chamar com outbox_mutex.
+ * 
+ * @return ESP_OK se inserida (ou coalescida), ESP_ERR_NO_MEM se descartada
+ */
+static esp_err_t outbox_insere(const char *topico, const void *dados, size_t tamanho, bool coalescer, bool reter)
+{
+    size_t pos;
+
+#if CONFIG_MQTT_OUTBOX_COALESCE
+    // Substitui o valor ainda nao enviado do mesmo topico pelo mais recente
+    for (size_t i = 0; coalescer && i < outbox_qtd; i++)
+    {
+        pos = (outbox_inicio + i) % OUTBOX_TAMANHO;
+        if (strcmp(outbox[pos].topico, topico) == 0)
+        {
+            memcpy(outbox[pos].dados, dados, tamanho);
+            outbox[pos].tamanho = tamanho;
+            estatisticas.coalescidas++;
+            return ESP_OK;
+        }
+    }
+#endif
+
+    if (outbox_qtd == OUTBOX_TAMANHO)
+    {
+        estatisticas.descartadas++;
+#if CONFIG_MQTT_OUTBOX_DROP_NEWEST
+        return ESP_ERR_NO_MEM;
+#else
+        // Descarta a mais antiga para abrir espaço
+        outbox_inicio = (outbox_inicio + 1) % OUTBOX_TAMANHO;
+        outbox_qtd--;
+#endif
+    }
+
+    pos = (outbox_inicio + outbox_qtd) % OUTBOX_TAMANHO;
+    strcpy(outbox[pos].topico, topico);
+    memcpy(outbox[pos].dados, dados, tamanho);
+    outbox[pos].tamanho = tamanho;
+    outbox[pos].reter = reter;
+    outbox_qtd++;
+    return ESP_OK;
+}
+
+/**
+ * @brief Enfileira uma mensagem e acorda a task de publicação.
+ * 
+ * @param topico tópico de destino
+ * @param dados conteúdo da mensagem
+ * @param tamanho tamanho do conteúdo em bytes
+ * @param coalescer permite substituir uma mensagem pendente do mesmo tópico
+ * @param reter publica com a flag retain
+ */
+static esp_err_t mqtt_enfileira(const char *topico, const void *dados, size_t tamanho, bool coalescer, bool reter)
+{
+    esp_err_t ret;
+
+    if (outbox_mutex == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (strlen(topico) >= MQTT_TOPICO_MAX || tamanho > MQTT_MENSAGEM_MAX)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int64_t inicio = esp_timer_get_time();
+    xSemaphoreTake(outbox_mutex, portMAX_DELAY);
+    ret = outbox_insere(topico, dados, tamanho, coalescer, reter);
+    if (ret == ESP_OK)
+    {
+        estatisticas.enfileiradas++;
+    }
+    xSemaphoreGive(outbox_mutex);
+
+    int64_t latencia = esp_timer_get_time() - inicio;
+    estatisticas.latencia_enfileirar_us = latencia;
+    if (latencia > estatisticas.latencia_enfileirar_max_us)
+    {
+        estatisticas.latencia_enfileirar_max_us = latencia;
+    }
+
+    xTaskNotifyGive(task_publicacao);
+    return ret;
+}
+
+/**
+ * @brief Faz o envio de uma mensagem via MQTT, através da outbox.
+ * 
+ */
+esp_err_t mqtt_envia_mensagem(char *topico, char *mensagem)
+{
+    return mqtt_enfileira(topico, mensagem, strlen(mensagem), true, RETER_LEITURAS);
+}
+
+/**
+ * @brief Enfileira um bloco de dados binários; nunca é coalescido.
+ * 
+ */
+esp_err_t mqtt_envia_dados(const char *topico, const void *dados, size_t tamanho)
+{
+    return mqtt_enfileira(topico, dados, tamanho, false, false);
+}
+
+/**
+ * @brief Posições livres na outbox.
  * 
  */
-void mqtt_envia_mensagem(char *topico, char *mensagem)
+size_t mqtt_outbox_livre(void)
 {
-    int msg_id = esp_mqtt_client_publish(client, topico, mensagem, 0, 0, 0);
-    ESP_LOGI(TAG, "Mensagem enviada, ID: %d", msg_id);  
-}
\ No newline at end of file
+    size_t livre;
+    if (outbox_mutex == NULL)
+    {
+        return 0;
+    }
+    xSemaphoreTake(outbox_mutex, portMAX_DELAY);
+    livre = OUTBOX_TAMANHO - outbox_qtd;
+    xSemaphoreGive(outbox_mutex);
+    return livre;
+}
+
+/**
+ * @brief Registra a função chamada a cada comando recebido.
+ * 
+ */
+void mqtt_registra_comando(mqtt_comando_cb_t cb)
+{
+    comando_cb = cb;
+}
+
+/**
+ * @brief Copia os contadores da outbox e da janela de QoS1.
+ * 
+ */
+void mqtt_estatisticas(mqtt_estatisticas_t *est)
+{
+    *est = estatisticas;
+}
@@ -1,17 +1,93 @@
 #ifndef MQTT_H
 #define MQTT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#define MQTT_TOPICO_MAX 48                            // Tamanho máximo do tópico, com terminador
+#define MQTT_MENSAGEM_MAX CONFIG_MQTT_MENSAGEM_MAX    // Tamanho máximo da mensagem
+#define MQTT_MENSAGENS_POR_CICLO 8                    // Publicadas por ciclo: 5 leituras, tendência, variação em 3 h e previsão
+
+/**
+ * @brief Contadores da outbox e da janela de QoS1.
+ */
+typedef struct {
+    uint32_t enfileiradas;              // Mensagens aceitas na outbox
+    uint32_t descartadas;               // Mensagens perdidas por outbox cheia
+    uint32_t coalescidas;               // Mensagens substituídas por um valor mais recente do mesmo tópico
+    uint32_t publicadas;                // Mensagens entregues ao cliente MQTT
+    uint32_t confirmadas;               // Mensagens com PUBACK recebido
+    uint32_t retransmissoes;            // Reenvios de mensagens recusadas pelo cliente (os reenvios com DUP do esp-mqtt não aparecem aqui)
+    uint32_t expiradas;                 // Mensagens liberadas da janela sem PUBACK (ou ainda recusadas) após o timeout
+    uint32_t em_voo;                    // Mensagens QoS1 aguardando PUBACK
+    int64_t latencia_enfileirar_us;     // Latência da última chamada a mqtt_envia_mensagem
+    int64_t latencia_enfileirar_max_us; // Maior latência observada
+    uint32_t conexoes;                  // Conexões completadas (CONNACK recebido)
+    uint32_t conexoes_sessao_presente;  // CONNACKs com session present (sessão MQTT persistente; não é retomada de TLS)
+    uint32_t tempo_conexao_ms;          // Duração da última conexão (TCP, TLS e CONNECT)
+    uint32_t tempo_conexao_max_ms;      // Maior duração de conexão observada
+} mqtt_estatisticas_t;
+
+/**
+ * @brief Função chamada quando chega uma mensagem no tópico de comandos.
+ * 
+ * @param dados conteúdo da mensagem (sem terminador)
+ * @param tamanho tamanho do conteúdo
+ */
+typedef void (*mqtt_comando_cb_t)(const char *dados, int tamanho);
+
 /**
  * @brief Configura MQTT e inicia comunicação.
  * 
+ * Registra o last will {"estado":"offline"} em CONFIG_MQTT_TOPICO_STATUS e, a cada
+ * conexão, publica ali o status online com as versões de firmware e de configuração.
  */
 void mqtt_start();
 
 /**
- * @brief Faz o envio de uma mensagem via MQTT
+ * @brief Enfileira uma mensagem para envio via MQTT, sem bloquear na rede.
+ * 
+ * Com CONFIG_MQTT_RETER_LEITURAS a mensagem é publicada com retain, e o broker
+ * a entrega como último valor a quem assinar o tópico depois.
  * 
  * @param topico String que descreve o topico que sera enviado
  * @param mensagem String do valor que será enviada ao broker
+ * 
+ * @return ESP_OK se enfileirada, ESP_ERR_NO_MEM se descartada pela política de transbordo
+ */
+esp_err_t mqtt_envia_mensagem(char *topico, char *mensagem);
+
+/**
+ * @brief Enfileira um bloco de dados binários. Ao contrário de mqtt_envia_mensagem,
+ * nunca substitui uma mensagem pendente do mesmo tópico.
+ * 
+ * @param topico tópico de destino
+ * @param dados conteúdo
+ * @param tamanho tamanho do conteúdo (no máximo MQTT_MENSAGEM_MAX)
+ * 
+ * @return ESP_OK se enfileirado
+ */
+esp_err_t mqtt_envia_dados(const char *topico, const void *dados, size_t tamanho);
+
+/**
+ * @brief Quantidade de posições livres na outbox, para quem envia em blocos controlar o fluxo.
+ */
+size_t mqtt_outbox_livre(void);
+
+/**
+ * @brief Registra a função chamada quando chega um comando remoto (CONFIG_MQTT_TOPICO_COMANDO).
+ * 
+ * @param cb função chamada no contexto da task do cliente MQTT; não deve bloquear
+ */
+void mqtt_registra_comando(mqtt_comando_cb_t cb);
+
+/**
+ * @brief Lê os contadores de publicação.
+ * 
+ * @param est estrutura que recebe a cópia dos contadores
  */
-void mqtt_envia_mensagem(char *topico, char *mensagem);
+void mqtt_estatisticas(mqtt_estatisticas_t *est);
 
 #endif
\ No newline at end of file
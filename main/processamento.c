@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "processamento.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+
+/**
+ * @brief Função de compensação de temperatura
+ * @param adc_T valor do registrador de temperatura
+ * @param calib parâmetros de calibração
+ * @param t_fine temperatura fina, usada pelas compensações de pressão e umidade
+ * Fonte: datasheet BME280, Bosch.
+ */
+static int32_t temperatura(int32_t adc_T, const bme280_calib_t *calib, int32_t *t_fine)
+{
+   int32_t var1, var2, T;
+   var1 = ((((adc_T>>3)-((int32_t)calib->dig_T1<<1)))*((int32_t)calib->dig_T2)) >> 11;
+   var2 = (((((adc_T>>4)-((int32_t)calib->dig_T1))*((adc_T>>4)-((int32_t)calib->dig_T1)))>>12)*((int32_t)calib->dig_T3))>>14;
+   *t_fine = var1 + var2;
+   T = ((*t_fine)*5+128)>>8;
+   return T;
+}
+
+/**
+ * @brief Função de compensação de pressão
+ * @param adc_P valor do registrador de pressão
+ * @param calib parâmetros de calibração
+ * @param t_fine temperatura fina
+ * Fonte: datasheet BME280, Bosch.
+ */
+static int32_t pressao(int32_t adc_P, const bme280_calib_t *calib, int32_t t_fine)
+{
+   int32_t var1, var2;
+   uint32_t p;
+   var1 = (((int32_t)t_fine)>>1) - (int32_t)64000;
+   var2 = (((var1>>2) * (var1>>2)) >> 11 ) * ((int32_t)calib->dig_P6);
+   var2 = var2 + ((var1*((int32_t)calib->dig_P5))<<1);
+   var2 = (var2>>2)+(((int32_t)calib->dig_P4)<<16);
+   var1 = (((calib->dig_P3 * (((var1>>2) * (var1>>2)) >> 13 )) >> 3) + ((((int32_t)calib->dig_P2) * var1)>>1))>>18;
+   var1 =((((32768+var1))*((int32_t)calib->dig_P1))>>15);
+   if (var1 == 0) {
+      return 0;
+   }
+   p = (((uint32_t)(((int32_t)1048576)-adc_P)-(var2>>12)))*3125;
+   if (p < 0x80000000) {
+      p = (p << 1) / ((uint32_t)var1);
+   } else {
+      p = (p / (uint32_t)var1) * 2;
+   }
+   var1 = (((int32_t)calib->dig_P9) * ((int32_t)(((p>>3) * (p>>3))>>13)))>>12;
+   var2 = (((int32_t)(p>>2)) * ((int32_t)calib->dig_P8))>>13;
+   p = (uint32_t)((int32_t)p + ((var1 + var2 + calib->dig_P7) >> 4));
+   return p;
+}
+
+/**
+ * @brief Função de compensação de umidade
+ * 
+ * @param adc_H valor do registrador de umidade
+ * @param calib parâmetros de calibração
+ * @param t_fine temperatura fina
+ * 
+ * @return int valor da umidade
+ * 
+ * Fonte: datasheet BME280, Bosch.
+ */
+static int32_t umidade(int32_t adc_H, const bme280_calib_t *calib, int32_t t_fine)
+{
+   int32_t v_x1_u32r;
+   v_x1_u32r = (t_fine - ((int32_t)76800));
+   v_x1_u32r = (((((adc_H << 14) - (((int32_t)calib->dig_H4) << 20) - (((int32_t)calib->dig_H5) * v_x1_u32r)) + ((int32_t)16384)) >> 15) * (((((((v_x1_u32r * ((int32_t)calib->dig_H6)) >> 10) * (((v_x1_u32r * ((int32_t)calib->dig_H3)) >> 11) + ((int32_t)32768))) >> 10) + ((int32_t)2097152)) * ((int32_t)calib->dig_H2) + 8192) >> 14));
+   v_x1_u32r = (v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((int32_t)calib->dig_H1)) >> 4));
+   v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
+   v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
+   return (int32_t)(v_x1_u32r >> 12);
+}
+
+/**
+ * @brief Monta os parâmetros de calibração do BME280.
+ * 
+ */
+void processamento_bme280_calib(const uint8_t cal1[BME280_TAM_CALIB1], const uint8_t cal2[BME280_TAM_CALIB2], bme280_calib_t *calib)
+{
+   calib->dig_T1 = cal1[1] << 8 | cal1[0];
+   calib->dig_T2 = cal1[3] << 8 | cal1[2];
+   calib->dig_T3 = cal1[5] << 8 | cal1[4];
+   calib->dig_P1 = cal1[7] << 8 | cal1[6];
+   calib->dig_P2 = cal1[9] << 8 | cal1[8];
+   calib->dig_P3 = cal1[11] << 8 | cal1[10];
+   calib->dig_P4 = cal1[13] << 8 | cal1[12];
+   calib->dig_P5 = cal1[15] << 8 | cal1[14];
+   calib->dig_P6 = cal1[17] << 8 | cal1[16];
+   calib->dig_P7 = cal1[19] << 8 | cal1[18];
+   calib->dig_P8 = cal1[21] << 8 | cal1[20];
+   calib->dig_P9 = cal1[23] << 8 | cal1[22];
+   calib->dig_H1 = cal1[25];                          // 0xA1 (0xA0 não é usado)
+   calib->dig_H2 = cal2[1] << 8 | cal2[0];
+   calib->dig_H3 = cal2[2];
+   calib->dig_H4 = cal2[3] << 4 | (cal2[4] & 0x0F);
+   calib->dig_H5 = cal2[5] << 4 | (cal2[4] >> 4);
+   calib->dig_H6 = cal2[6];
+}
+
+/**
+ * @brief Soma de bits dos registradores e funções de compensação.
+ * 
+ */
+void processamento_bme280(const bme280_calib_t *calib, const uint8_t dados[BME280_TAM_DADOS], int32_t *temp, int32_t *pabs, int32_t *umid)
+{
+   int32_t adc_T, adc_P, adc_H, t_fine;
+
+   adc_P = (dados[2] >> 4) | (dados[1] << 4) | (dados[0] << 12);
+   adc_T = (dados[5] >> 4) | (dados[4] << 4) | (dados[3] << 12);
+   adc_H = dados[7] | (dados[6] << 8);
+
+   *temp = temperatura(adc_T, calib, &t_fine);
+   *pabs = pressao(adc_P, calib, t_fine);
+   *umid = umidade(adc_H, calib, t_fine);
+}
+
+/**
+ * @brief Conversão do BH1750 para lux.
+ * 
+ */
+float processamento_lux(uint8_t msb, uint8_t lsb)
+{
+   return ((msb << 8 | lsb)/1.2);
+}
+
+/**
+ * @brief Conversão mV -> escala de 10 bits.
+ * 
+ */
+float processamento_chuva(uint32_t milivolts)
+{
+   // Regra de três para medir a quantidade de chuva em 10bits
+   return ((milivolts)*1023)/3250;
+}
+
+/**
+ * @brief Média das leituras do ADC.
+ * 
+ */
+uint32_t processamento_media(const uint16_t *amostras, size_t n)
+{
+   uint32_t soma = 0;
+   for (size_t i = 0; i < n; i++)
+   {
+      soma += amostras[i];
+   }
+   return soma / n;
+}
+
+/**
+ * @brief Formatação de ponto fixo: dígitos gerados de trás para frente e copiados invertidos.
+ * 
+ */
+int processamento_formata_fixo(char *destino, size_t tamanho, int32_t valor, int casas)
+{
+   char tmp[PROCESSAMENTO_CASAS_MAX + 12];   // Casas, ponto, até 10 dígitos inteiros e sinal
+   int n = 0;
+   uint32_t v = (valor < 0) ? -(uint32_t)valor : (uint32_t)valor;
+
+   if (casas < 0 || casas > PROCESSAMENTO_CASAS_MAX)
+   {
+      if (tamanho > 0)
+      {
+         destino[0] = '\0';
+      }
+      return -1;
+   }
+
+   for (int i = 0; i < casas; i++)
+   {
+      tmp[n++] = '0' + v % 10;
+      v /= 10;
+   }
+   if (casas > 0)
+   {
+      tmp[n++] = '.';
+   }
+   do
+   {
+      tmp[n++] = '0' + v % 10;
+      v /= 10;
+   } while (v != 0);
+   if (valor < 0)
+   {
+      tmp[n++] = '-';
+   }
+
+   if ((size_t)n >= tamanho)
+   {
+      if (tamanho > 0)
+      {
+         destino[0] = '\0';
+      }
+      return n;
+   }
+   for (int i = 0; i < n; i++)
+   {
+      destino[i] = tmp[n - 1 - i];
+   }
+   destino[n] = '\0';
+   return n;
+}
+
+/**
+ * @brief Formata um valor para o payload MQTT.
+ * 
+ * Converte para ponto fixo e usa processamento_formata_fixo; o printf de float só é usado
+ * para valores fora da faixa de int32 ou com mais de 6 casas. O produto de um float por
+ * até 10^6 é exato em double, e rint desempata para o par como o "%.*f" (ex.: 0.125 ->
+ * "0.12"); lround arredondaria para longe do zero. Um valor negativo que arredonda para
+ * zero mantém o sinal, como no printf ("-0.00"). tools/bench confere a equivalência.
+ */
+int processamento_formata(char *destino, size_t tamanho, float valor, int casas)
+{
+   static const int32_t potencias[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+   if (casas >= 0 && casas < (int)(sizeof(potencias) / sizeof(potencias[0])))
+   {
+      double escalado = (double)valor * potencias[casas];
+      if (escalado > -2147483647.0 && escalado < 2147483647.0)
+      {
+         int32_t fixo = (int32_t)rint(escalado);
+         if (fixo == 0 && signbit(valor) && tamanho > 1)
+         {
+            // -0.004 com 2 casas: o ponto fixo perde o sinal do zero
+            destino[0] = '-';
+            int n = processamento_formata_fixo(destino + 1, tamanho - 1, 0, casas);
+            if (n + 1 >= (int)tamanho)
+            {
+               destino[0] = '\0';
+            }
+            return n + 1;
+         }
+         return processamento_formata_fixo(destino, tamanho, fixo, casas);
+      }
+   }
+   return snprintf(destino, tamanho, "%.*f", casas, valor);
+}
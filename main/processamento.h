@@ -0,0 +1,100 @@
+#ifndef PROCESSAMENTO_H
+#define PROCESSAMENTO_H
+
+/**
+ * @brief Processamento puro das leituras: compensação, conversão e formatação dos payloads.
+ *
+ * Este módulo não depende do ESP-IDF, para que a mesma lógica rode no firmware e na
+ * ferramenta de replay no host (tools/replay).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BME280_TAM_DADOS   8   // Registradores 0xF7..0xFE (pressão, temperatura, umidade)
+#define BME280_TAM_CALIB1  26  // Registradores 0x88..0xA1
+#define BME280_TAM_CALIB2  7   // Registradores 0xE1..0xE7
+#define PROCESSAMENTO_CASAS_MAX 9   // Casas decimais aceitas por processamento_formata_fixo
+
+/**
+ * @brief Parâmetros de calibração do BME280 já montados.
+ */
+typedef struct {
+   uint16_t dig_T1;
+   int16_t dig_T2, dig_T3;
+   uint16_t dig_P1;
+   int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+   uint16_t dig_H1, dig_H3;
+   int16_t dig_H2, dig_H4, dig_H5, dig_H6;
+} bme280_calib_t;
+
+/**
+ * @brief Monta os parâmetros de calibração a partir dos blocos lidos do sensor.
+ *
+ * @param cal1 bytes de 0x88 a 0xA1
+ * @param cal2 bytes de 0xE1 a 0xE7
+ * @param calib parâmetros montados
+ */
+void processamento_bme280_calib(const uint8_t cal1[BME280_TAM_CALIB1], const uint8_t cal2[BME280_TAM_CALIB2], bme280_calib_t *calib);
+
+/**
+ * @brief Compensação dos registradores de dados do BME280.
+ *
+ * @param calib parâmetros de calibração
+ * @param dados bytes de 0xF7 a 0xFE
+ * @param temp temperatura em centésimos de °C
+ * @param pabs pressão em Pa
+ * @param umid umidade relativa em %/1024
+ */
+void processamento_bme280(const bme280_calib_t *calib, const uint8_t dados[BME280_TAM_DADOS], int32_t *temp, int32_t *pabs, int32_t *umid);
+
+/**
+ * @brief Conversão da leitura do BH1750 (modo H-Resolution) para lux.
+ *
+ * @param msb byte mais significativo
+ * @param lsb byte menos significativo
+ */
+float processamento_lux(uint8_t msb, uint8_t lsb);
+
+/**
+ * @brief Conversão da tensão do sensor de chuva para a escala de 10 bits.
+ *
+ * @param milivolts tensão já calibrada (esp_adc_cal_raw_to_voltage no firmware,
+ * valor gravado no trace no replay)
+ */
+float processamento_chuva(uint32_t milivolts);
+
+/**
+ * @brief Média das amostras do ADC do sensor de chuva.
+ *
+ * @param amostras leituras RAW
+ * @param n quantidade de leituras
+ */
+uint32_t processamento_media(const uint16_t *amostras, size_t n);
+
+/**
+ * @brief Formata em decimal um valor em ponto fixo, sem passar por float nem printf.
+ *
+ * @param destino buffer de saída
+ * @param tamanho tamanho do buffer
+ * @param valor valor já escalado por 10^casas (ex.: 2345 com 2 casas -> "23.45")
+ * @param casas casas decimais, de 0 a PROCESSAMENTO_CASAS_MAX
+ *
+ * @return quantidade de caracteres do resultado; se >= tamanho, destino fica vazio;
+ * -1 (destino vazio) se casas estiver fora da faixa
+ */
+int processamento_formata_fixo(char *destino, size_t tamanho, int32_t valor, int casas);
+
+/**
+ * @brief Formata um valor para o payload MQTT, com o mesmo texto de snprintf "%.*f".
+ *
+ * @param destino buffer de saída
+ * @param tamanho tamanho do buffer
+ * @param valor valor a formatar
+ * @param casas casas decimais
+ *
+ * @return quantidade de caracteres escritos
+ */
+int processamento_formata(char *destino, size_t tamanho, float valor, int casas);
+
+#endif
@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 
+#include "processamento.h"
+
 #include "esp_adc_cal.h"
 #include "driver/gpio.h"
 #include "driver/adc.h"
@@ -20,6 +22,8 @@ static const adc_unit_t unit = ADC_UNIT_1;              // SAR(Successive Approx
 static const adc_bits_width_t width = ADC_WIDTH_BIT_12; // Tamanho da leitura.
 static const adc_channel_t channel = ADC1_CHANNEL_0;    // Canal da leitura.
 static esp_adc_cal_characteristics_t *adc_chars;        // Criar estrutura de caracteristicas em adc_chars.
+static uint16_t ultimo_raw;                             // Média RAW da última leitura.
+static uint16_t ultimo_mv;                              // Tensão calibrada da última leitura.
 
 /**
  * @brief Inicializador do conversor ADC para aquisição de informações de chuva.
@@ -40,17 +44,35 @@ void rainsensor_start()
  */
 void rainsensor_read(float *analograin)
 {
-    uint32_t reading = 0, voltage;
+    uint16_t amostras[SAMPLES];
+    uint32_t reading;
     
     // Faz aquisição de amostras
     for (int i = 0; i < SAMPLES; i++){
-        reading += adc1_get_raw(ADC1_CHANNEL_0);
+        amostras[i] = adc1_get_raw(ADC1_CHANNEL_0);
     }
 
     // Divide a leitura pelo numero de amostras
-    reading /= SAMPLES;
-    // Conversão RAW -> mV
-    voltage = esp_adc_cal_raw_to_voltage(reading, adc_chars);
-    // Regra de três para medir a quantidade de chuva em 10bits
-    *analograin = ((voltage)*1023)/3250;
+    reading = processamento_media(amostras, SAMPLES);
+    ultimo_raw = reading;
+    // Conversão RAW -> mV pela caracterização completa (inclui a LUT do ESP32 em 11 dB)
+    ultimo_mv = esp_adc_cal_raw_to_voltage(reading, adc_chars);
+    // mV -> escala de 10 bits, com a mesma rotina usada no replay
+    *analograin = processamento_chuva(ultimo_mv);
+}
+
+/**
+ * @brief Média RAW e tensão calibrada da última leitura e coeficientes da caracterização do ADC.
+ * 
+ * @param raw média RAW
+ * @param mv tensão calibrada (mV)
+ * @param coeff_a coeficiente angular
+ * @param coeff_b coeficiente linear (mV)
+ */
+void rainsensor_brutos(uint16_t *raw, uint16_t *mv, uint32_t *coeff_a, uint32_t *coeff_b)
+{
+    *raw = ultimo_raw;
+    *mv = ultimo_mv;
+    *coeff_a = adc_chars->coeff_a;
+    *coeff_b = adc_chars->coeff_b;
 }
\ No newline at end of file
@@ -15,4 +15,14 @@ void rainsensor_start(void);
  */
 void rainsensor_read(float *analograin);
 
+/**
+ * @brief Média RAW e tensão calibrada da última leitura e coeficientes do ADC, para captura de traces.
+ * 
+ * @param raw média RAW
+ * @param mv tensão calibrada por esp_adc_cal_raw_to_voltage (mV)
+ * @param coeff_a coeficiente angular da caracterização
+ * @param coeff_b coeficiente linear da caracterização (mV)
+ */
+void rainsensor_brutos(uint16_t *raw, uint16_t *mv, uint32_t *coeff_a, uint32_t *coeff_b);
+
 #endif
\ No newline at end of file
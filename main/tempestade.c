@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "tempestade.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "esp_timer.h"
+
+#include "mqtt.h"
+#include "logbuf.h"
+#include "tempestade_bloco.h"
+
+#define PERIODO_VIGIA_MS   CONFIG_TEMPESTADE_PERIODO_VIGIA_MS
+#define PERIODO_RAJADA_MS  CONFIG_TEMPESTADE_PERIODO_RAJADA_MS
+#define AMOSTRAS_PRE       CONFIG_TEMPESTADE_AMOSTRAS_PRE
+#define AMOSTRAS_POS       (CONFIG_TEMPESTADE_DURACAO_RAJADA_S * 1000 / PERIODO_RAJADA_MS)
+#define AMOSTRAS_JANELA_P  (60000 / PERIODO_VIGIA_MS)       // Amostras de vigia em 1 minuto
+#define LIMIAR_PRESSAO_PA  CONFIG_TEMPESTADE_LIMIAR_PRESSAO_PA
+#define LIMIAR_CHUVA       CONFIG_TEMPESTADE_LIMIAR_CHUVA
+#define INTERVALO_MIN_US   ((int64_t)CONFIG_TEMPESTADE_INTERVALO_MIN_S * 1000000)
+#define RESERVA_OUTBOX     MQTT_MENSAGENS_POR_CICLO         // Posições deixadas para um ciclo de publicação normal
+
+#define TOPICO_TEMPESTADE  "topic/tempestade"
+#define RAM_MAXIMA         (48 * 1024)                      // Histórico + evento, em DRAM estática
+
+_Static_assert(AMOSTRAS_JANELA_P < AMOSTRAS_PRE, "historico pre-gatilho menor que a janela de pressao");
+_Static_assert(MQTT_MENSAGEM_MAX >= TEMPESTADE_BLOCO_CABECALHO + TEMPESTADE_BLOCO_MAX_AMOSTRA, "mensagem MQTT pequena para um bloco");
+// Com a outbox menor ou igual à reserva, o envio nunca avança e o detector fica preso em ESTADO_ENVIO
+_Static_assert(CONFIG_MQTT_OUTBOX_LEN > RESERVA_OUTBOX, "MQTT_OUTBOX_LEN deve ser maior que a reserva da tempestade");
+
+typedef enum {
+    ESTADO_VIGIA,
+    ESTADO_RAJADA,
+    ESTADO_ENVIO
+} estado_t;
+
+static tempestade_amostra_t historico[AMOSTRAS_PRE];   // Circular, na taxa de vigia
+static size_t historico_pos = 0;
+static size_t historico_qtd = 0;
+
+static tempestade_amostra_t evento[AMOSTRAS_PRE + AMOSTRAS_POS];   // Pré-gatilho + rajada
+
+_Static_assert(sizeof(historico) + sizeof(evento) <= RAM_MAXIMA,
+               "rajada grande demais: reduza TEMPESTADE_DURACAO_RAJADA_S ou aumente TEMPESTADE_PERIODO_RAJADA_MS");
+static size_t evento_qtd = 0;
+static size_t evento_gatilho = 0;                      // Índice da primeira amostra pós-gatilho
+static size_t evento_enviadas = 0;
+static uint16_t evento_seq = 0;
+static uint8_t evento_id = 0;
+static tempestade_gatilho_t evento_motivo;
+
+static estado_t estado = ESTADO_VIGIA;
+static int64_t fim_rajada_us = 0;
+static int64_t ultimo_evento_us = 0;
+static bool primeiro_evento = true;
+static volatile bool gatilho_remoto = false;
+
+/**
+ * @brief Amostra do histórico, contando a partir da mais recente (0).
+ */
+static const tempestade_amostra_t *historico_atras(size_t n)
+{
+    return &historico[(historico_pos + AMOSTRAS_PRE - 1 - n) % AMOSTRAS_PRE];
+}
+
+/**
+ * @brief Avalia os gatilhos sobre o histórico de vigia.
+ */
+static tempestade_gatilho_t verifica_gatilhos(void)
+{
+    if (gatilho_remoto)
+    {
+        gatilho_remoto = false;
+        return TEMPESTADE_GATILHO_REMOTO;
+    }
+    if (!primeiro_evento && esp_timer_get_time() - ultimo_evento_us < INTERVALO_MIN_US)
+    {
+        // Limita o ciclo de trabalho: no máximo uma rajada por intervalo
+        return TEMPESTADE_GATILHO_NENHUM;
+    }
+    if (historico_qtd >= 2 && historico_atras(0)->chuva < LIMIAR_CHUVA && historico_atras(1)->chuva >= LIMIAR_CHUVA)
+    {
+        return TEMPESTADE_GATILHO_CHUVA;
+    }
+    if (historico_qtd > AMOSTRAS_JANELA_P)
+    {
+        int32_t dp = historico_atras(0)->pabs_pa - historico_atras(AMOSTRAS_JANELA_P)->pabs_pa;
+        if (dp >= LIMIAR_PRESSAO_PA || dp <= -LIMIAR_PRESSAO_PA)
+        {
+            return TEMPESTADE_GATILHO_PRESSAO;
+        }
+    }
+    return TEMPESTADE_GATILHO_NENHUM;
+}
+
+/**
+ * @brief Copia o histórico pré-gatilho, em ordem cronológica, para o início do evento.
+ */
+static void inicia_evento(tempestade_gatilho_t motivo)
+{
+    for (size_t i = 0; i < historico_qtd; i++)
+    {
+        evento[i] = *historico_atras(historico_qtd - 1 - i);
+    }
+    evento_qtd = historico_qtd;
+    evento_gatilho = historico_qtd;
+    evento_enviadas = 0;
+    evento_seq = 0;
+    evento_id++;
+    evento_motivo = motivo;
+    ultimo_evento_us = esp_timer_get_time();
+    primeiro_evento = false;
+    fim_rajada_us = ultimo_evento_us + (int64_t)CONFIG_TEMPESTADE_DURACAO_RAJADA_S * 1000000;
+    estado = ESTADO_RAJADA;
+    LOGB(LOGBUF_MOD_TEMPESTADE, LOGBUF_INFO, LOG_RAJADA_INICIADA, motivo);
+}
+
+/**
+ * @brief Envia blocos do evento enquanto houver espaço na outbox além da reserva.
+ */
+static void envia_blocos(void)
+{
+    uint8_t bloco[MQTT_MENSAGEM_MAX];
+    while (evento_enviadas < evento_qtd && mqtt_outbox_livre() > RESERVA_OUTBOX)
+    {
+        tempestade_cabecalho_t cab = {
+            .evento_id = evento_id,
+            .seq = evento_seq,
+            .motivo = evento_motivo,
+            .gatilho = evento_gatilho,
+        };
+        size_t n = tempestade_bloco_codifica(bloco, sizeof(bloco), &evento[evento_enviadas], evento_qtd - evento_enviadas, &cab);
+        if (mqtt_envia_dados(TOPICO_TEMPESTADE, bloco, n) != ESP_OK)
+        {
+            // Tenta o mesmo bloco de novo na próxima amostra
+            return;
+        }
+        evento_enviadas += cab.qtd;
+        evento_seq++;
+    }
+    if (evento_enviadas == evento_qtd)
+    {
+        LOGB(LOGBUF_MOD_TEMPESTADE, LOGBUF_INFO, LOG_EVENTO_ENVIADO, evento_id, evento_qtd, evento_seq);
+        estado = ESTADO_VIGIA;
+    }
+}
+
+/**
+ * @brief Comando remoto recebido pelo MQTT.
+ */
+static void comando(const char *dados, int tamanho)
+{
+    if (tamanho == 10 && strncmp(dados, "tempestade", 10) == 0)
+    {
+        tempestade_dispara();
+    }
+}
+
+/**
+ * @brief Prepara a detecção de tempestade.
+ * 
+ */
+void tempestade_start(void)
+{
+    mqtt_registra_comando(comando);
+}
+
+/**
+ * @brief Dispara a rajada.
+ * 
+ */
+void tempestade_dispara(void)
+{
+    gatilho_remoto = true;
+}
+
+/**
+ * @brief Período do estado atual.
+ * 
+ */
+uint32_t tempestade_periodo_atual(void)
+{
+    return (estado == ESTADO_RAJADA) ? PERIODO_RAJADA_MS : PERIODO_VIGIA_MS;
+}
+
+/**
+ * @brief Entrega uma amostra ao detector.
+ * 
+ */
+uint32_t tempestade_amostra(float temp, float pabs, float umid, float chuva)
+{
+    tempestade_amostra_t a = {
+        .tempo_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .pabs_pa = lroundf(pabs * 100),
+        .temp_cc = lroundf(temp * 100),
+        .umid_c = lroundf(umid * 100),
+        .chuva = (uint16_t)chuva,
+    };
+
+    switch (estado)
+    {
+        case ESTADO_RAJADA:
+            evento[evento_qtd++] = a;
+            if (evento_qtd == AMOSTRAS_PRE + AMOSTRAS_POS || esp_timer_get_time() >= fim_rajada_us)
+            {
+                estado = ESTADO_ENVIO;
+                envia_blocos();
+                return PERIODO_VIGIA_MS;
+            }
+            return PERIODO_RAJADA_MS;
+        case ESTADO_ENVIO:
+        case ESTADO_VIGIA:
+            historico[historico_pos] = a;
+            historico_pos = (historico_pos + 1) % AMOSTRAS_PRE;
+            if (historico_qtd < AMOSTRAS_PRE)
+            {
+                historico_qtd++;
+            }
+            if (estado == ESTADO_ENVIO)
+            {
+                envia_blocos();
+                return PERIODO_VIGIA_MS;
+            }
+            tempestade_gatilho_t motivo = verifica_gatilhos();
+            if (motivo != TEMPESTADE_GATILHO_NENHUM)
+            {
+                inicia_evento(motivo);
+                return PERIODO_RAJADA_MS;
+            }
+            return PERIODO_VIGIA_MS;
+    }
+    return PERIODO_VIGIA_MS;
+}
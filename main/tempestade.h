@@ -0,0 +1,51 @@
+#ifndef TEMPESTADE_H
+#define TEMPESTADE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Motivos de disparo da amostragem em rajada.
+ */
+typedef enum {
+    TEMPESTADE_GATILHO_NENHUM = 0,
+    TEMPESTADE_GATILHO_CHUVA,       // Início de chuva
+    TEMPESTADE_GATILHO_PRESSAO,     // Variação de pressão acima do limiar
+    TEMPESTADE_GATILHO_REMOTO       // Comando MQTT
+} tempestade_gatilho_t;
+
+/**
+ * @brief Prepara os buffers e registra o comando remoto de disparo.
+ */
+void tempestade_start(void);
+
+/**
+ * @brief Entrega uma amostra ao detector de tempestade.
+ *
+ * Em vigia, guarda a amostra no histórico pré-gatilho e avalia os gatilhos; em rajada,
+ * acumula o evento; depois da rajada, envia o evento comprimido em blocos pela outbox MQTT.
+ *
+ * @param temp temperatura (°C)
+ * @param pabs pressão (hPa)
+ * @param umid umidade (%)
+ * @param chuva leitura do sensor de chuva (10 bits)
+ *
+ * @return tempo em ms até a próxima amostra
+ */
+uint32_t tempestade_amostra(float temp, float pabs, float umid, float chuva);
+
+/**
+ * @brief Período de amostragem do estado atual, sem entregar amostra.
+ *
+ * Usado quando a leitura falha, para que uma falha transitória do sensor no meio de uma
+ * rajada não derrube a amostragem para o período de publicação.
+ *
+ * @return tempo em ms até a próxima amostra
+ */
+uint32_t tempestade_periodo_atual(void);
+
+/**
+ * @brief Dispara a rajada manualmente, como o comando remoto.
+ */
+void tempestade_dispara(void);
+
+#endif
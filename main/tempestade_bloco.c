@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "tempestade_bloco.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define BYTES_VARINT_MAX 5
+
+/**
+ * @brief Escreve um inteiro com sinal como varint zigzag.
+ * 
+ * @return bytes escritos
+ */
+static size_t escreve_varint(uint8_t *buf, int32_t valor)
+{
+   uint32_t z = ((uint32_t)valor << 1) ^ (uint32_t)(valor >> 31);
+   size_t n = 0;
+   while (z >= 0x80)
+   {
+      buf[n++] = (uint8_t)(z | 0x80);
+      z >>= 7;
+   }
+   buf[n++] = (uint8_t)z;
+   return n;
+}
+
+/**
+ * @brief Lê um varint zigzag.
+ * 
+ * @return bytes lidos, ou 0 se truncado ou com mais de 5 bytes
+ */
+static size_t le_varint(const uint8_t *buf, size_t tamanho, int32_t *valor)
+{
+   uint32_t z = 0;
+   for (size_t n = 0; n < tamanho && n < BYTES_VARINT_MAX; n++)
+   {
+      z |= (uint32_t)(buf[n] & 0x7F) << (7 * n);
+      if ((buf[n] & 0x80) == 0)
+      {
+         *valor = (int32_t)((z >> 1) ^ -(z & 1));
+         return n + 1;
+      }
+   }
+   return 0;
+}
+
+static void escreve_u16(uint8_t *buf, uint16_t valor)
+{
+   buf[0] = valor & 0xFF;
+   buf[1] = valor >> 8;
+}
+
+static uint16_t le_u16(const uint8_t *buf)
+{
+   return buf[0] | buf[1] << 8;
+}
+
+/**
+ * @brief Codificação em delta contra a amostra anterior do mesmo bloco.
+ * 
+ */
+size_t tempestade_bloco_codifica(uint8_t *buf, size_t tamanho, const tempestade_amostra_t *amostras, size_t restantes,
+                                 tempestade_cabecalho_t *cab)
+{
+   size_t n = TEMPESTADE_BLOCO_CABECALHO;
+   uint16_t qtd = 0;
+   tempestade_amostra_t anterior;
+   uint8_t codificada[TEMPESTADE_BLOCO_MAX_AMOSTRA];
+   memset(&anterior, 0, sizeof(anterior));
+
+   while (qtd < restantes && qtd < UINT16_MAX)
+   {
+      const tempestade_amostra_t *a = &amostras[qtd];
+      size_t m = escreve_varint(&codificada[0], (int32_t)(a->tempo_ms - anterior.tempo_ms));
+      m += escreve_varint(&codificada[m], (int32_t)((uint32_t)a->pabs_pa - (uint32_t)anterior.pabs_pa));
+      m += escreve_varint(&codificada[m], a->temp_cc - anterior.temp_cc);
+      m += escreve_varint(&codificada[m], a->umid_c - anterior.umid_c);
+      m += escreve_varint(&codificada[m], a->chuva - anterior.chuva);
+      if (n + m > tamanho)
+      {
+         break;
+      }
+      memcpy(&buf[n], codificada, m);
+      n += m;
+      anterior = *a;
+      qtd++;
+   }
+
+   cab->versao = TEMPESTADE_BLOCO_VERSAO;
+   cab->qtd = qtd;
+   cab->flags = (qtd == restantes) ? TEMPESTADE_BLOCO_ULTIMO : 0;
+   buf[0] = cab->versao;
+   buf[1] = cab->evento_id;
+   escreve_u16(&buf[2], cab->seq);
+   buf[4] = cab->flags;
+   buf[5] = cab->motivo;
+   escreve_u16(&buf[6], cab->qtd);
+   escreve_u16(&buf[8], cab->gatilho);
+   return n;
+}
+
+/**
+ * @brief Decodificação: soma os deltas a partir de zero.
+ * 
+ */
+int tempestade_bloco_decodifica(const uint8_t *buf, size_t tamanho, tempestade_cabecalho_t *cab,
+                                tempestade_amostra_t *amostras, size_t max)
+{
+   if (tamanho < TEMPESTADE_BLOCO_CABECALHO || buf[0] != TEMPESTADE_BLOCO_VERSAO)
+   {
+      return -1;
+   }
+   cab->versao = buf[0];
+   cab->evento_id = buf[1];
+   cab->seq = le_u16(&buf[2]);
+   cab->flags = buf[4];
+   cab->motivo = buf[5];
+   cab->qtd = le_u16(&buf[6]);
+   cab->gatilho = le_u16(&buf[8]);
+   if (cab->qtd > max)
+   {
+      return -1;
+   }
+
+   size_t n = TEMPESTADE_BLOCO_CABECALHO;
+   tempestade_amostra_t anterior;
+   memset(&anterior, 0, sizeof(anterior));
+   for (uint16_t i = 0; i < cab->qtd; i++)
+   {
+      int32_t d[5];
+      for (int c = 0; c < 5; c++)
+      {
+         size_t m = le_varint(&buf[n], tamanho - n, &d[c]);
+         if (m == 0)
+         {
+            return -1;
+         }
+         n += m;
+      }
+      tempestade_amostra_t *a = &amostras[i];
+      memset(a, 0, sizeof(*a));
+      a->tempo_ms = anterior.tempo_ms + (uint32_t)d[0];
+      a->pabs_pa = (int32_t)((uint32_t)anterior.pabs_pa + (uint32_t)d[1]);
+      a->temp_cc = (int16_t)(anterior.temp_cc + d[2]);
+      a->umid_c = (uint16_t)(anterior.umid_c + d[3]);
+      a->chuva = (uint16_t)(anterior.chuva + d[4]);
+      anterior = *a;
+   }
+   return (n == tamanho) ? cab->qtd : -1;
+}
@@ -0,0 +1,82 @@
+#ifndef TEMPESTADE_BLOCO_H
+#define TEMPESTADE_BLOCO_H
+
+/**
+ * @brief Formato dos blocos de evento publicados em topic/tempestade.
+ *
+ * Cada bloco tem um cabeçalho de 10 bytes (versão, id do evento, sequência u16, flags,
+ * motivo, quantidade de amostras u16, índice do gatilho no evento u16, little-endian)
+ * seguido das amostras em delta e varint zigzag. A primeira amostra de cada bloco é
+ * codificada contra zero, então todo bloco pode ser decodificado sozinho. Não depende do
+ * ESP-IDF, para que o decodificador do host (tools/tempestade) use o mesmo código.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TEMPESTADE_BLOCO_VERSAO      1
+#define TEMPESTADE_BLOCO_CABECALHO   10
+#define TEMPESTADE_BLOCO_MAX_AMOSTRA 25    // 5 varints de até 5 bytes
+#define TEMPESTADE_BLOCO_ULTIMO      0x01  // Flag do último bloco do evento
+
+/**
+ * @brief Amostra compacta: 16 bytes.
+ */
+typedef struct {
+   uint32_t tempo_ms;
+   int32_t pabs_pa;
+   int16_t temp_cc;     // centésimos de °C
+   uint16_t umid_c;     // centésimos de %
+   uint16_t chuva;
+   uint16_t reservado;
+} tempestade_amostra_t;
+
+_Static_assert(sizeof(tempestade_amostra_t) == 16, "tamanho da amostra de tempestade");
+
+/**
+ * @brief Cabeçalho de um bloco.
+ */
+typedef struct {
+   uint8_t versao;
+   uint8_t evento_id;
+   uint16_t seq;        // Posição do bloco no evento, a partir de 0
+   uint8_t flags;
+   uint8_t motivo;      // tempestade_gatilho_t
+   uint16_t qtd;        // Amostras neste bloco
+   uint16_t gatilho;    // Índice, no evento, da primeira amostra pós-gatilho
+} tempestade_cabecalho_t;
+
+/**
+ * @brief Codifica o próximo bloco de um evento.
+ *
+ * Codifica, a partir de amostras[0], quantas amostras couberem em tamanho bytes. O
+ * cabeçalho é escrito com evento_id, seq, motivo e gatilho de cab; qtd e flags são
+ * preenchidos aqui (último bloco quando todas as restantes couberam).
+ *
+ * @param buf destino
+ * @param tamanho tamanho do destino (no mínimo cabeçalho + uma amostra)
+ * @param amostras amostras ainda não enviadas do evento
+ * @param restantes quantidade de amostras ainda não enviadas
+ * @param cab cabeçalho do bloco
+ *
+ * @return tamanho do bloco; cab->qtd diz quantas amostras foram consumidas
+ */
+size_t tempestade_bloco_codifica(uint8_t *buf, size_t tamanho, const tempestade_amostra_t *amostras, size_t restantes,
+                                 tempestade_cabecalho_t *cab);
+
+/**
+ * @brief Decodifica um bloco.
+ *
+ * @param buf bloco recebido
+ * @param tamanho tamanho do bloco
+ * @param cab cabeçalho lido
+ * @param amostras destino das amostras
+ * @param max capacidade de amostras
+ *
+ * @return quantidade de amostras, ou -1 se o bloco estiver truncado, tiver outra versão,
+ * bytes sobrando ou mais amostras que max
+ */
+int tempestade_bloco_decodifica(const uint8_t *buf, size_t tamanho, tempestade_cabecalho_t *cab,
+                                tempestade_amostra_t *amostras, size_t max);
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "tendencia.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define LIMIAR_ESTAVEL_HPA_H  0.1f   // |inclinação| abaixo disto é considerada estável
+#define LIMIAR_ESTAVEL_3H_HPA 0.1f   // Variação em 3 h considerada "igual"
+#define LIMIAR_ZAMBRETTI_HPA  1.6f   // Variação em 3 h que define subindo/descendo
+
+/**
+ * @brief Atualiza as somas de uma janela de tamanho w com a nova amostra y.
+ * 
+ * @param j janela
+ * @param w tamanho da janela
+ * @param y amostra que entra
+ * @param y_sai amostra que sai (usada somente com a janela cheia)
+ */
+static void janela_adiciona(tendencia_janela_t *j, size_t w, int32_t y, int32_t y_sai)
+{
+   if (j->qtd < w)
+   {
+      j->soma_iy += (int64_t)j->qtd * y;
+      j->soma_y += y;
+      j->qtd++;
+   }
+   else
+   {
+      // Todas as amostras restantes recuam uma posição: i*y perde soma_y - y_sai
+      j->soma_iy += -(j->soma_y - y_sai) + (int64_t)(w - 1) * y;
+      j->soma_y += y - y_sai;
+   }
+}
+
+/**
+ * @brief Inclinação de mínimos quadrados, em Pa por amostra.
+ * 
+ */
+static float inclinacao(size_t n, int64_t soma_y, int64_t soma_iy)
+{
+   int64_t sx = (int64_t)n * (n - 1) / 2;
+   int64_t denominador = (int64_t)n * n * ((int64_t)n * n - 1) / 12;
+   if (n < 2)
+   {
+      return 0;
+   }
+   return (float)((double)((int64_t)n * soma_iy - sx * soma_y) / (double)denominador);
+}
+
+/**
+ * @brief Classifica uma inclinação em subindo (1), estável (0) ou descendo (-1).
+ */
+static int sentido(float hpa_h)
+{
+   if (hpa_h > LIMIAR_ESTAVEL_HPA_H)
+   {
+      return 1;
+   }
+   if (hpa_h < -LIMIAR_ESTAVEL_HPA_H)
+   {
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * @brief Zera o estado.
+ * 
+ */
+void tendencia_inicia(tendencia_t *t)
+{
+   memset(t, 0, sizeof(*t));
+}
+
+/**
+ * @brief Adiciona uma amostra.
+ * 
+ */
+void tendencia_adiciona(tendencia_t *t, int32_t pabs_pa)
+{
+   int32_t sai3 = t->pressoes[t->pos];
+   int32_t sai1 = t->pressoes[(t->pos + TENDENCIA_N3 - TENDENCIA_N1) % TENDENCIA_N3];
+
+   janela_adiciona(&t->j1, TENDENCIA_N1, pabs_pa, sai1);
+   janela_adiciona(&t->j3, TENDENCIA_N3, pabs_pa, sai3);
+   t->pressoes[t->pos] = pabs_pa;
+   t->pos = (t->pos + 1) % TENDENCIA_N3;
+}
+
+/**
+ * @brief Inclinação em hPa/h.
+ * 
+ */
+bool tendencia_inclinacao(const tendencia_t *t, int horas, float *hpa_por_hora)
+{
+   const tendencia_janela_t *j = (horas == 1) ? &t->j1 : &t->j3;
+   size_t w = (horas == 1) ? TENDENCIA_N1 : TENDENCIA_N3;
+   if (j->qtd < w)
+   {
+      return false;
+   }
+   *hpa_por_hora = inclinacao(j->qtd, j->soma_y, j->soma_iy) * TENDENCIA_AMOSTRAS_HORA / 100;
+   return true;
+}
+
+/**
+ * @brief Código WMO 0200 a partir da variação em 3 h e das inclinações das 2 primeiras
+ * horas (início) e da última hora (fim) da janela.
+ * 
+ */
+int tendencia_codigo_wmo(const tendencia_t *t)
+{
+   float tardia, total;
+   if (!tendencia_inclinacao(t, 1, &tardia) || !tendencia_inclinacao(t, 3, &total))
+   {
+      return -1;
+   }
+
+   // As 2 primeiras horas saem das somas de 3 h menos as da última hora, reindexadas
+   size_t n_inicio = TENDENCIA_N3 - TENDENCIA_N1;
+   int64_t soma_y = t->j3.soma_y - t->j1.soma_y;
+   int64_t soma_iy = t->j3.soma_iy - (t->j1.soma_iy + (int64_t)n_inicio * t->j1.soma_y);
+   float inicial = inclinacao(n_inicio, soma_y, soma_iy) * TENDENCIA_AMOSTRAS_HORA / 100;
+
+   float variacao = total * 3;
+   int s_ini = sentido(inicial);
+   int s_fim = sentido(tardia);
+
+   if (fabsf(variacao) <= LIMIAR_ESTAVEL_3H_HPA && s_ini == 0 && s_fim == 0)
+   {
+      return 4;                                    // Estável
+   }
+   if (variacao >= 0)
+   {
+      if (s_ini > 0 && s_fim < 0) return 0;        // Subindo, depois descendo
+      if (s_ini > 0 && s_fim == 0) return 1;       // Subindo, depois estável
+      if (s_ini > 0 && tardia < inicial / 2) return 1;   // Subindo mais devagar
+      if (s_ini <= 0 && s_fim > 0) return 3;       // Descendo/estável, depois subindo
+      if (s_ini > 0 && tardia > inicial * 2) return 3;   // Subindo mais rápido
+      if (s_fim < 0) return 0;
+      return 2;                                    // Subindo
+   }
+   if (s_ini < 0 && s_fim > 0) return 5;           // Descendo, depois subindo
+   if (s_ini < 0 && s_fim == 0) return 6;          // Descendo, depois estável
+   if (s_ini < 0 && tardia > inicial / 2) return 6;      // Descendo mais devagar
+   if (s_ini >= 0 && s_fim < 0) return 8;          // Subindo/estável, depois descendo
+   if (s_ini < 0 && tardia < inicial * 2) return 8;      // Descendo mais rápido
+   if (s_fim > 0) return 5;
+   return 7;                                       // Descendo
+}
+
+/**
+ * @brief Pressão ao nível do mar.
+ * 
+ */
+float tendencia_nivel_mar(float pabs_hpa, float temp_c, float altitude_m)
+{
+   return pabs_hpa * powf(1.0f - (0.0065f * altitude_m) / (temp_c + 0.0065f * altitude_m + 273.15f), -5.257f);
+}
+
+/**
+ * @brief Previsão de Zambretti (aproximação linear das tabelas de Negretti & Zambra).
+ * 
+ */
+char tendencia_zambretti(float p0_hpa, float variacao_3h_hpa)
+{
+   static const char descendo[] = "ABDHORUVX";          // Z = 1..9
+   static const char estavel[] = "ABEKNPSWXZ";          // Z = 10..19
+   static const char subindo[] = "ABCFGIJLMQTYZ";       // Z = 20..32
+   const char *tabela;
+   int z, inicio, tamanho;
+
+   if (variacao_3h_hpa <= -LIMIAR_ZAMBRETTI_HPA)
+   {
+      z = lroundf(127 - 0.12f * p0_hpa);
+      tabela = descendo; inicio = 1; tamanho = sizeof(descendo) - 1;
+   }
+   else if (variacao_3h_hpa >= LIMIAR_ZAMBRETTI_HPA)
+   {
+      z = lroundf(185 - 0.16f * p0_hpa);
+      tabela = subindo; inicio = 20; tamanho = sizeof(subindo) - 1;
+   }
+   else
+   {
+      z = lroundf(144 - 0.13f * p0_hpa);
+      tabela = estavel; inicio = 10; tamanho = sizeof(estavel) - 1;
+   }
+
+   z -= inicio;
+   if (z < 0)
+   {
+      z = 0;
+   }
+   if (z >= tamanho)
+   {
+      z = tamanho - 1;
+   }
+   return tabela[z];
+}
@@ -0,0 +1,86 @@
+#ifndef TENDENCIA_H
+#define TENDENCIA_H
+
+/**
+ * @brief Tendência barométrica incremental e previsão de curto prazo (Zambretti).
+ *
+ * Regressão linear de mínimos quadrados da pressão sobre janelas deslizantes de 1 h e 3 h,
+ * atualizada em O(1) por amostra a partir de somas inteiras num buffer circular de tamanho fixo.
+ * Não depende do ESP-IDF, para rodar também no replay do host (tools/replay).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define TENDENCIA_AMOSTRAS_HORA 60                               // Uma amostra por publicação (60 s)
+#define TENDENCIA_N1 (1 * TENDENCIA_AMOSTRAS_HORA)
+#define TENDENCIA_N3 (3 * TENDENCIA_AMOSTRAS_HORA)
+
+/**
+ * @brief Janela deslizante: somas de y e de i*y, com i = 0 para a amostra mais antiga.
+ */
+typedef struct {
+   size_t qtd;
+   int64_t soma_y;
+   int64_t soma_iy;
+} tendencia_janela_t;
+
+typedef struct {
+   int32_t pressoes[TENDENCIA_N3];   // Pa, circular
+   size_t pos;                       // Próxima posição de escrita
+   tendencia_janela_t j1;            // Última hora
+   tendencia_janela_t j3;            // Últimas 3 horas
+} tendencia_t;
+
+/**
+ * @brief Zera o estado da tendência.
+ */
+void tendencia_inicia(tendencia_t *t);
+
+/**
+ * @brief Adiciona uma amostra de pressão, em O(1).
+ *
+ * @param t estado
+ * @param pabs_pa pressão em Pa
+ */
+void tendencia_adiciona(tendencia_t *t, int32_t pabs_pa);
+
+/**
+ * @brief Inclinação da regressão na janela de 1 h ou 3 h.
+ *
+ * @param t estado
+ * @param horas 1 ou 3
+ * @param hpa_por_hora inclinação em hPa/h
+ *
+ * @return false enquanto a janela não estiver cheia
+ */
+bool tendencia_inclinacao(const tendencia_t *t, int horas, float *hpa_por_hora);
+
+/**
+ * @brief Característica da tendência barométrica (WMO, tabela de código 0200).
+ *
+ * @return código de 0 a 8, ou -1 enquanto não houver 3 h de dados
+ */
+int tendencia_codigo_wmo(const tendencia_t *t);
+
+/**
+ * @brief Redução da pressão da estação ao nível do mar (fórmula hipsométrica).
+ *
+ * @param pabs_hpa pressão na estação
+ * @param temp_c temperatura do ar
+ * @param altitude_m altitude da estação
+ */
+float tendencia_nivel_mar(float pabs_hpa, float temp_c, float altitude_m);
+
+/**
+ * @brief Previsão de Zambretti.
+ *
+ * @param p0_hpa pressão ao nível do mar
+ * @param variacao_3h_hpa variação de pressão em 3 h
+ *
+ * @return letra de 'A' (tempo firme) a 'Z' (tempestuoso)
+ */
+char tendencia_zambretti(float p0_hpa, float variacao_3h_hpa);
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "trace.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+
+#include "trace_formato.h"
+#include "bme280.h"
+#include "bh1750.h"
+#include "rainsensor.h"
+
+#define TRACE_SUBTIPO 0x40
+#define TRACE_ROTULO "trace"
+
+#define TAG "TRACE"
+
+static const esp_partition_t *particao = NULL;
+static size_t posicao = 0;
+static uint32_t calib_gravada = 0;      // bme280_calibracao_versao() do último registro de sessão
+
+/**
+ * @brief Grava um registro na próxima posição livre da partição.
+ * 
+ * @param reg registro a gravar
+ */
+static esp_err_t grava_registro(trace_registro_t *reg)
+{
+    if (particao == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (posicao + TRACE_TAM_REGISTRO > particao->size)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    reg->tempo_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    esp_err_t ret = esp_partition_write(particao, posicao, reg, TRACE_TAM_REGISTRO);
+    if (ret == ESP_OK)
+    {
+        posicao += TRACE_TAM_REGISTRO;
+    }
+    return ret;
+}
+
+/**
+ * @brief Procura o fim da gravação anterior (primeiro registro apagado).
+ * 
+ */
+static void procura_fim(void)
+{
+    uint8_t tipo;
+    posicao = 0;
+    while (posicao + TRACE_TAM_REGISTRO <= particao->size)
+    {
+        if (esp_partition_read(particao, posicao, &tipo, 1) != ESP_OK || tipo == TRACE_VAZIO)
+        {
+            break;
+        }
+        posicao += TRACE_TAM_REGISTRO;
+    }
+}
+
+/**
+ * @brief Grava um registro de sessão com a calibração atual do BME280.
+ * 
+ * @param recalibracao calibração relida depois do boot (o replay mantém a tendência)
+ */
+static esp_err_t grava_sessao(bool recalibracao)
+{
+    trace_registro_t reg;
+    uint32_t coeff_a, coeff_b;
+    uint16_t raw, mv;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.tipo = TRACE_SESSAO;
+    reg.sessao.recalibracao = recalibracao;
+    calib_gravada = bme280_calibracao_versao();
+    bme280_calibracao_bruta(reg.sessao.cal1, reg.sessao.cal2);
+    rainsensor_brutos(&raw, &mv, &coeff_a, &coeff_b);
+    reg.sessao.adc_coeff_a = coeff_a;
+    reg.sessao.adc_coeff_b = coeff_b;
+    return grava_registro(&reg);
+}
+
+/**
+ * @brief Abre a partição de trace e grava o registro de sessão.
+ * 
+ */
+esp_err_t trace_start(void)
+{
+    particao = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, TRACE_SUBTIPO, TRACE_ROTULO);
+    if (particao == NULL)
+    {
+        ESP_LOGE(TAG, "Particao '%s' nao encontrada", TRACE_ROTULO);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+#if CONFIG_TRACE_APAGAR_NO_BOOT
+    ESP_ERROR_CHECK(esp_partition_erase_range(particao, 0, particao->size));
+    posicao = 0;
+#else
+    procura_fim();
+#endif
+    ESP_LOGI(TAG, "Gravando trace a partir de %u/%u bytes", (unsigned)posicao, (unsigned)particao->size);
+
+    // Com o BME280 ausente no boot a calibração ainda é zero; trace_registra_amostra grava
+    // outro registro de sessão quando ela for lida
+    return grava_sessao(false);
+}
+
+/**
+ * @brief Grava a última amostra bruta dos sensores, precedida de um registro de sessão se a
+ * calibração do BME280 foi relida desde o último.
+ * 
+ */
+esp_err_t trace_registra_amostra(bool lux_valido)
+{
+    trace_registro_t reg;
+    uint32_t coeff_a, coeff_b;
+    uint16_t raw, mv;
+    esp_err_t ret;
+
+    if (bme280_calibracao_versao() != calib_gravada && (ret = grava_sessao(true)) != ESP_OK)
+    {
+        return ret;
+    }
+
+    memset(&reg, 0, sizeof(reg));
+    reg.tipo = TRACE_AMOSTRA;
+    bme280_brutos(reg.amostra.bme280);
+    bh1750_brutos(reg.amostra.bh1750);
+    reg.amostra.lux_invalido = !lux_valido;
+    rainsensor_brutos(&raw, &mv, &coeff_a, &coeff_b);
+    reg.amostra.chuva_raw = raw;
+    reg.amostra.chuva_mv = mv;
+    return grava_registro(&reg);
+}
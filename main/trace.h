@@ -0,0 +1,28 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/**
+ * @brief Abre a partição de trace e grava um registro de sessão com as calibrações.
+ * Deve ser chamada depois da inicialização dos sensores.
+ *
+ * @return ESP_ERR_NOT_FOUND se não existir partição "trace" na tabela de partições
+ */
+esp_err_t trace_start(void);
+
+/**
+ * @brief Grava os bytes brutos da última leitura de cada sensor. Chamar somente com
+ * leitura válida do BME280, que é quando o firmware alimenta a tendência. Se a calibração
+ * do BME280 foi relida (sensor ausente no boot ou reconectado), grava antes um novo
+ * registro de sessão.
+ *
+ * @param lux_valido a última leitura do BH1750 foi válida
+ *
+ * @return ESP_ERR_NO_MEM quando a partição está cheia
+ */
+esp_err_t trace_registra_amostra(bool lux_valido);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef TRACE_FORMATO_H
+#define TRACE_FORMATO_H
+
+/**
+ * @brief Formato dos registros de trace gravados na partição "trace".
+ *
+ * Compartilhado entre o firmware e a ferramenta de replay (tools/replay), por isso
+ * não depende do ESP-IDF. Registros de tamanho fixo, little-endian, gravados em sequência;
+ * o primeiro byte 0xFF (flash apagada) marca o fim da gravação.
+ */
+
+#include <stdint.h>
+
+#include "processamento.h"
+
+#define TRACE_TAM_REGISTRO 64
+
+/**
+ * @brief Tipos de registro.
+ */
+typedef enum {
+    TRACE_SESSAO  = 0x01,   // Início de captura ou recalibração: calibrações do BME280 e do ADC
+    TRACE_AMOSTRA = 0x02,   // Uma amostra bruta de todos os sensores
+    TRACE_VAZIO   = 0xFF    // Flash apagada, fim dos registros
+} trace_tipo_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t cal1[BME280_TAM_CALIB1];
+    uint8_t cal2[BME280_TAM_CALIB2];
+    uint8_t recalibracao;   // 0: início de captura (boot); 1: calibração relida no mesmo boot
+    uint32_t adc_coeff_a;   // Caracterização do ADC, só para diagnóstico: a conversão usa chuva_mv
+    uint32_t adc_coeff_b;
+} trace_sessao_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t bme280[BME280_TAM_DADOS];
+    uint8_t bh1750[2];
+    uint16_t chuva_raw;
+    uint16_t chuva_mv;      // Tensão calibrada pelo esp_adc_cal (LUT incluída), entrada da conversão
+    uint8_t lux_invalido;   // Leitura do BH1750 falhou: bh1750 contém a leitura anterior e não foi publicada
+} trace_amostra_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t tipo;
+    uint8_t reservado[3];
+    uint32_t tempo_ms;      // Tempo desde o boot
+    union {
+        trace_sessao_t sessao;
+        trace_amostra_t amostra;
+        uint8_t bytes[TRACE_TAM_REGISTRO - 8];
+    };
+} trace_registro_t;
+
+_Static_assert(sizeof(trace_registro_t) == TRACE_TAM_REGISTRO, "tamanho do registro de trace");
+
+#endif
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @brief Microbenchmarks no host das rotinas puras do firmware (main/processamento.c,
+ * main/tendencia.c): compensação do BME280, média do sensor de chuva, conversão de lux
+ * e formatação dos payloads (sprintf "%.2f" contra o formatador de ponto fixo).
+ *
+ * Antes das medições, confere que processamento_formata gera o mesmo texto que o snprintf
+ * em todas as leituras possíveis de cada grandeza publicada, na variação em 3 h (inclusive
+ * negativos que arredondam para "-0.00") e em floats aleatórios com 0 a 6 casas, e que
+ * processamento_formata_fixo recusa casas fora da faixa; sai com 1 se algo divergir.
+ *
+ * Compilação:  gcc -O2 -Imain tools/bench/bench.c main/processamento.c main/tendencia.c -lm -o bench
+ * Uso:         ./bench [rotulo] >> bench.csv
+ *
+ * Cada linha é "rotulo,rotina,ns_por_op"; usando o hash do commit como rótulo
+ * (./bench $(git rev-parse --short HEAD)), o CSV acumula o histórico entre commits.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "processamento.h"
+#include "tendencia.h"
+
+#define ITERACOES 2000000
+#define AMOSTRAS_CHUVA 64
+
+// Calibração e leitura de exemplo do datasheet do BME280 (Bosch)
+static const uint8_t cal1[BME280_TAM_CALIB1] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B,
+    0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17, 0x00, 0x4B
+};
+static const uint8_t cal2[BME280_TAM_CALIB2] = { 0x6A, 0x01, 0x00, 0x13, 0x2A, 0x03, 0x1E };
+static const uint8_t dados[BME280_TAM_DADOS] = { 0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00, 0x6D, 0x60 };
+
+static volatile int32_t sumidouro;
+
+/**
+ * @brief Compara processamento_formata com snprintf "%.*f" para valor/divisor, com valor
+ * de minimo a maximo.
+ *
+ * @return quantidade de divergências
+ */
+static int confere_formata(const char *grandeza, int32_t minimo, int32_t maximo, float divisor, int casas)
+{
+    char esperado[32], obtido[32];
+    int divergencias = 0;
+    for (int32_t v = minimo; v <= maximo; v++)
+    {
+        float valor = (float)v / divisor;
+        snprintf(esperado, sizeof(esperado), "%.*f", casas, valor);
+        processamento_formata(obtido, sizeof(obtido), valor, casas);
+        if (strcmp(esperado, obtido) != 0 && divergencias++ == 0)
+        {
+            fprintf(stderr, "%s: %d/%g formatado \"%s\", snprintf \"%s\"\n", grandeza, (int)v, divisor, obtido, esperado);
+        }
+    }
+    if (divergencias > 0)
+    {
+        fprintf(stderr, "%s: %d divergencias\n", grandeza, divergencias);
+    }
+    return divergencias;
+}
+
+/**
+ * @brief Lux pelo mesmo caminho do firmware (processamento_lux), em todas as leituras do BH1750.
+ *
+ * @return quantidade de divergências
+ */
+static int confere_lux(void)
+{
+    char esperado[32], obtido[32];
+    int divergencias = 0;
+    for (int32_t v = 0; v <= 0xFFFF; v++)
+    {
+        float lux = processamento_lux(v >> 8, v & 0xFF);
+        snprintf(esperado, sizeof(esperado), "%.2f", lux);
+        processamento_formata(obtido, sizeof(obtido), lux, 2);
+        divergencias += strcmp(esperado, obtido) != 0;
+    }
+    if (divergencias > 0)
+    {
+        fprintf(stderr, "luminosidade: %d divergencias\n", divergencias);
+    }
+    return divergencias;
+}
+
+/**
+ * @brief Floats aleatórios (padrões de bits) dentro da faixa do ponto fixo, com 0 a 6 casas.
+ *
+ * @return quantidade de divergências
+ */
+static int confere_aleatorios(void)
+{
+    static const double limites[] = { 2e9, 2e8, 2e7, 2e6, 2e5, 2e4, 2e3 };
+    char esperado[48], obtido[48];
+    uint32_t semente = 1;
+    int divergencias = 0;
+    for (int i = 0; i < 1000000; i++)
+    {
+        semente = semente * 1664525u + 1013904223u;
+        float valor;
+        memcpy(&valor, &semente, sizeof(valor));
+        int casas = i % 7;
+        if (!(fabs(valor) < limites[casas]))
+        {
+            continue;
+        }
+        snprintf(esperado, sizeof(esperado), "%.*f", casas, valor);
+        processamento_formata(obtido, sizeof(obtido), valor, casas);
+        if (strcmp(esperado, obtido) != 0 && divergencias++ == 0)
+        {
+            fprintf(stderr, "aleatorio: %a com %d casas formatado \"%s\", snprintf \"%s\"\n", valor, casas, obtido, esperado);
+        }
+    }
+    if (divergencias > 0)
+    {
+        fprintf(stderr, "aleatorio: %d divergencias\n", divergencias);
+    }
+    return divergencias;
+}
+
+/**
+ * @brief Casas fora da faixa: destino vazio e retorno -1, sem escrever além do buffer.
+ *
+ * @return quantidade de divergências
+ */
+static int confere_casas_invalidas(void)
+{
+    char texto[64];
+    int divergencias = 0;
+    for (int casas = PROCESSAMENTO_CASAS_MAX + 1; casas <= 40; casas++)
+    {
+        strcpy(texto, "x");
+        divergencias += processamento_formata_fixo(texto, sizeof(texto), -123456789, casas) != -1 || texto[0] != '\0';
+    }
+    strcpy(texto, "x");
+    divergencias += processamento_formata_fixo(texto, sizeof(texto), 1, -1) != -1 || texto[0] != '\0';
+    if (divergencias > 0)
+    {
+        fprintf(stderr, "casas invalidas: %d divergencias\n", divergencias);
+    }
+    return divergencias;
+}
+
+static double agora_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void relata(const char *rotulo, const char *rotina, double inicio)
+{
+    printf("%s,%s,%.2f\n", rotulo, rotina, (agora_ns() - inicio) / ITERACOES);
+}
+
+int main(int argc, char **argv)
+{
+    const char *rotulo = argc > 1 ? argv[1] : "local";
+    bme280_calib_t calib;
+    uint16_t chuva[AMOSTRAS_CHUVA];
+    char texto[16];
+    int32_t t, p, u;
+    double inicio;
+    static tendencia_t tend;
+
+    // Faixas de saída da compensação do BME280 (temperatura em centésimos de °C, pressão em Pa,
+    // umidade em %/1024) e do sensor de chuva (0 a 1023, sem casas)
+    if (confere_formata("temperatura", -4000, 8500, 100, 2) + confere_formata("pressao", 30000, 110000, 100, 2) +
+        confere_formata("umidade", 0, 102400, 1024, 2) + confere_formata("chuva", 0, 1023, 1, 0) + confere_lux() +
+        confere_formata("tendencia_3h", -100000, 100000, 1000, 2) + confere_formata("menos_zero", 0, 0, -1, 2) +
+        confere_aleatorios() + confere_casas_invalidas() > 0)
+    {
+        return 1;
+    }
+
+    for (int i = 0; i < AMOSTRAS_CHUVA; i++)
+    {
+        chuva[i] = 1800 + (i * 37) % 200;
+    }
+
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        processamento_bme280_calib(cal1, cal2, &calib);
+        sumidouro = calib.dig_P9;
+    }
+    relata(rotulo, "bme280_calib", inicio);
+
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        processamento_bme280(&calib, dados, &t, &p, &u);
+        sumidouro = t + p + u;
+    }
+    relata(rotulo, "bme280_compensacao", inicio);
+
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        chuva[i % AMOSTRAS_CHUVA] ^= 1;
+        sumidouro = processamento_media(chuva, AMOSTRAS_CHUVA);
+    }
+    relata(rotulo, "chuva_media64", inicio);
+
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        sumidouro = (int32_t)processamento_chuva(1600 + (i & 0xFF));
+    }
+    relata(rotulo, "chuva_conversao", inicio);
+
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        sumidouro = (int32_t)processamento_lux(i >> 8, i & 0xFF);
+    }
+    relata(rotulo, "lux_conversao", inicio);
+
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        sumidouro = snprintf(texto, sizeof(texto), "%.2f", (float)(p + (i & 0xFF)) / 100);
+    }
+    relata(rotulo, "formata_sprintf", inicio);
+
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        sumidouro = processamento_formata(texto, sizeof(texto), (float)(p + (i & 0xFF)) / 100, 2);
+    }
+    relata(rotulo, "formata_float", inicio);
+
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        sumidouro = processamento_formata_fixo(texto, sizeof(texto), p + (i & 0xFF), 2);
+    }
+    relata(rotulo, "formata_fixo", inicio);
+
+    tendencia_inicia(&tend);
+    inicio = agora_ns();
+    for (int i = 0; i < ITERACOES; i++)
+    {
+        tendencia_adiciona(&tend, p + (i & 0x3FF));
+        sumidouro = tendencia_codigo_wmo(&tend);
+    }
+    relata(rotulo, "tendencia_amostra", inicio);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @brief Medição de jitter da amostragem no host (Linux/POSIX), com a mesma estatística
+ * do firmware (main/jitter.c) e o mesmo esquema da CONFIG_JITTER_MEDICAO: uma thread de
+ * amostragem em prioridade de tempo real, com capturas em instantes absolutos, e uma
+ * thread de carga em prioridade normal (SCHED_OTHER) enviando datagramas UDP (aqui para
+ * a loopback).
+ *
+ * Compilação:  gcc -O2 -Imain tools/jitter/jitter.c main/jitter.c -lm -lpthread -o jitter
+ * Uso:         ./jitter [periodo_ms] [capturas] [pacotes_s] [nucleo_amostragem] [nucleo_carga]
+ *              padrão: 10 ms, 6000 capturas, 20000 pacotes/s, núcleos 1 e 0
+ *
+ * É o mesmo mapeamento que a porta POSIX do FreeRTOS (alvo linux do ESP-IDF) faz: cada
+ * task vira uma thread. SCHED_FIFO exige root ou CAP_SYS_NICE; sem isso a medição roda
+ * em prioridade normal e o aviso é impresso.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "jitter.h"
+
+#define PRIORIDADE_AMOSTRAGEM 80
+#define CARGA_PORTA 9
+#define CARGA_TAMANHO 512
+#define CARGA_CICLO_MS 10
+
+static volatile int executando = 1;
+static int pacotes_s = 20000;
+static int nucleo_carga = 0;
+
+static int64_t agora_us(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void soma_ns(struct timespec *t, int64_t ns)
+{
+   t->tv_nsec += ns;
+   while (t->tv_nsec >= 1000000000)
+   {
+      t->tv_nsec -= 1000000000;
+      t->tv_sec++;
+   }
+}
+
+static void fixa_nucleo(int nucleo)
+{
+   cpu_set_t cpus;
+   CPU_ZERO(&cpus);
+   CPU_SET(nucleo, &cpus);
+   if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+   {
+      fprintf(stderr, "aviso: nao foi possivel fixar a thread no nucleo %d\n", nucleo);
+   }
+}
+
+/**
+ * @brief Carga sintética: rajadas de datagramas UDP a cada CARGA_CICLO_MS.
+ */
+static void *thread_carga(void *param)
+{
+   static char carga[CARGA_TAMANHO];
+   struct sockaddr_in destino = {
+      .sin_family = AF_INET,
+      .sin_port = htons(CARGA_PORTA),
+      .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+   };
+   int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+   struct timespec proximo;
+   int64_t acumulado = 0;      // Pacotes x 1000 ainda não enviados, para taxas abaixo de 1 por ciclo
+
+   (void)param;
+   if (sock < 0)
+   {
+      fprintf(stderr, "aviso: falha ao criar o socket da carga (%s), medindo sem carga\n", strerror(errno));
+      pacotes_s = 0;
+      return NULL;
+   }
+   fixa_nucleo(nucleo_carga);
+   memset(carga, 'c', sizeof(carga));
+   clock_gettime(CLOCK_MONOTONIC, &proximo);
+   while (executando)
+   {
+      acumulado += (int64_t)pacotes_s * CARGA_CICLO_MS;
+      for (; acumulado >= 1000; acumulado -= 1000)
+      {
+         sendto(sock, carga, sizeof(carga), 0, (struct sockaddr *)&destino, sizeof(destino));
+      }
+      soma_ns(&proximo, (int64_t)CARGA_CICLO_MS * 1000000);
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &proximo, NULL);
+   }
+   close(sock);
+   return NULL;
+}
+
+int main(int argc, char **argv)
+{
+   int periodo_ms = argc > 1 ? atoi(argv[1]) : 10;
+   int capturas = argc > 2 ? atoi(argv[2]) : 6000;
+   int nucleo_amostragem = argc > 4 ? atoi(argv[4]) : 1;
+   pacotes_s = argc > 3 ? atoi(argv[3]) : pacotes_s;
+   nucleo_carga = argc > 5 ? atoi(argv[5]) : nucleo_carga;
+
+   static jitter_t j;
+   char relatorio[160];
+   pthread_t carga;
+   pthread_attr_t atributos;
+   struct sched_param normal = { .sched_priority = 0 };
+   struct timespec proximo;
+   struct sched_param prioridade = { .sched_priority = PRIORIDADE_AMOSTRAGEM };
+
+   if (periodo_ms <= 0 || capturas <= 0)
+   {
+      fprintf(stderr, "uso: %s [periodo_ms] [capturas] [pacotes_s] [nucleo_amostragem] [nucleo_carga]\n", argv[0]);
+      return 1;
+   }
+   if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &prioridade) != 0)
+   {
+      fprintf(stderr, "aviso: sem SCHED_FIFO, medindo em prioridade normal\n");
+   }
+   fixa_nucleo(nucleo_amostragem);
+   jitter_inicia(&j);
+   // Sem herdar o SCHED_FIFO desta thread: a carga roda em prioridade normal, como as
+   // tarefas de rede abaixo da amostragem no firmware
+   pthread_attr_init(&atributos);
+   pthread_attr_setinheritsched(&atributos, PTHREAD_EXPLICIT_SCHED);
+   pthread_attr_setschedpolicy(&atributos, SCHED_OTHER);
+   pthread_attr_setschedparam(&atributos, &normal);
+   if (pthread_create(&carga, &atributos, thread_carga, NULL) != 0)
+   {
+      fprintf(stderr, "falha ao criar a thread de carga\n");
+      return 1;
+   }
+   pthread_attr_destroy(&atributos);
+
+   clock_gettime(CLOCK_MONOTONIC, &proximo);
+   for (int i = 0; i < capturas; i++)
+   {
+      jitter_registra(&j, agora_us(), (int64_t)periodo_ms * 1000);
+      soma_ns(&proximo, (int64_t)periodo_ms * 1000000);
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &proximo, NULL);
+   }
+   executando = 0;
+   pthread_join(carga, NULL);
+
+   jitter_relatorio(&j, relatorio, sizeof(relatorio));
+   printf("jitter: periodo=%dms carga=%dpps %s\n", periodo_ms, pacotes_s, relatorio);
+   return 0;
+}
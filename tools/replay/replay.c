@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @brief Replay no host de traces gravados pelo firmware (CONFIG_TRACE_CAPTURA).
+ *
+ * Passa cada amostra bruta pelas mesmas rotinas de compensação, conversão e formatação
+ * do firmware (main/processamento.c, main/tendencia.c) e imprime os payloads em CSV. Com repetições > 0,
+ * mede também a vazão do pipeline sobre os dados de campo.
+ *
+ * Compilação:  gcc -O2 -Imain tools/replay/replay.c main/processamento.c main/tendencia.c -lm -o replay
+ * Extração:    parttool.py read_partition --partition-name trace --output trace.bin
+ * Uso:         ./replay [-a altitude_m] trace.bin [repeticoes]
+ *              altitude_m deve ser a CONFIG_ALTITUDE_ESTACAO da estação (padrão 0), usada na previsão
+ * Regressão:   tools/replay/verifica.sh compara a saída do trace de referência (amostras/)
+ *              com o CSV esperado
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "processamento.h"
+#include "trace_formato.h"
+#include "tendencia.h"
+
+/**
+ * @brief Saída do pipeline para uma amostra: os mesmos payloads publicados via MQTT.
+ */
+typedef struct {
+    char chuva[16];
+    char temperatura[16];
+    char umidade[16];
+    char pressao[16];
+    char luminosidade[16];
+    int tendencia;          // Código WMO, -1 sem 3 h de histórico
+    char previsao;
+} payloads_t;
+
+static float altitude_m = 0;    // CONFIG_ALTITUDE_ESTACAO da estação que gravou o trace
+
+/**
+ * @brief Processa uma amostra bruta como a task de amostragem faz.
+ * 
+ */
+static void processa_amostra(const trace_amostra_t *amostra, const bme280_calib_t *calib, tendencia_t *tend, payloads_t *saida)
+{
+    float inclinacao_3h;
+    int32_t t, p, u;
+    processamento_bme280(calib, amostra->bme280, &t, &p, &u);
+    float lux = processamento_lux(amostra->bh1750[0], amostra->bh1750[1]);
+    // A calibração RAW -> mV (esp_adc_cal, com LUT) é feita no dispositivo e gravada no trace
+    float rain = processamento_chuva(amostra->chuva_mv);
+    processamento_formata(saida->chuva, sizeof(saida->chuva), rain, 0);
+    processamento_formata(saida->temperatura, sizeof(saida->temperatura), (float)t/100, 2);
+    processamento_formata(saida->umidade, sizeof(saida->umidade), (float)u/1024, 2);
+    processamento_formata(saida->pressao, sizeof(saida->pressao), (float)p/100, 2);
+    if (amostra->lux_invalido)
+    {
+        saida->luminosidade[0] = '\0';           // Não publicada pelo firmware
+    }
+    else
+    {
+        processamento_formata(saida->luminosidade, sizeof(saida->luminosidade), lux, 2);
+    }
+    tendencia_adiciona(tend, p);
+    saida->tendencia = tendencia_codigo_wmo(tend);
+    saida->previsao = '-';
+    if (saida->tendencia >= 0 && tendencia_inclinacao(tend, 3, &inclinacao_3h))
+    {
+        saida->previsao = tendencia_zambretti(tendencia_nivel_mar((float)p/100, (float)t/100, altitude_m), inclinacao_3h * 3);
+    }
+}
+
+/**
+ * @brief Percorre todos os registros do trace.
+ * 
+ * @param regs registros lidos do arquivo
+ * @param n quantidade de registros
+ * @param imprime imprime o CSV
+ * 
+ * @return quantidade de amostras processadas
+ */
+static size_t replay(const trace_registro_t *regs, size_t n, int imprime)
+{
+    bme280_calib_t calib;
+    int tem_sessao = 0;
+    size_t amostras = 0;
+    payloads_t saida;
+    static tendencia_t tend;
+
+    tendencia_inicia(&tend);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const trace_registro_t *reg = &regs[i];
+        if (reg->tipo == TRACE_VAZIO)
+        {
+            break;
+        }
+        if (reg->tipo == TRACE_SESSAO)
+        {
+            processamento_bme280_calib(reg->sessao.cal1, reg->sessao.cal2, &calib);
+            tem_sessao = 1;
+            if (!reg->sessao.recalibracao)
+            {
+                // Nova sessão = novo boot: o firmware também recomeça a tendência
+                tendencia_inicia(&tend);
+            }
+        }
+        else if (reg->tipo == TRACE_AMOSTRA && tem_sessao)
+        {
+            processa_amostra(&reg->amostra, &calib, &tend, &saida);
+            amostras++;
+            if (imprime)
+            {
+                printf("%u,%s,%s,%s,%s,%s,%d,%c\n", (unsigned)reg->tempo_ms, saida.chuva, saida.temperatura,
+                       saida.umidade, saida.pressao, saida.luminosidade, saida.tendencia, saida.previsao);
+            }
+        }
+    }
+    return amostras;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2 && strcmp(argv[1], "-a") == 0)
+    {
+        altitude_m = atof(argv[2]);
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 2)
+    {
+        fprintf(stderr, "uso: replay [-a altitude_m] trace.bin [repeticoes]\n");
+        return 1;
+    }
+    int repeticoes = argc > 2 ? atoi(argv[2]) : 0;
+
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long tamanho = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    size_t n = tamanho / TRACE_TAM_REGISTRO;
+    trace_registro_t *regs = malloc(n * sizeof(trace_registro_t) + 1);
+    if (regs == NULL || fread(regs, TRACE_TAM_REGISTRO, n, f) != n)
+    {
+        fprintf(stderr, "falha ao ler %s\n", argv[1]);
+        return 1;
+    }
+    fclose(f);
+
+    printf("tempo_ms,chuva,temperatura,umidade,pressao,luminosidade,tendencia,previsao\n");
+    size_t amostras = replay(regs, n, 1);
+
+    if (repeticoes > 0 && amostras > 0)
+    {
+        struct timespec ini, fim;
+        clock_gettime(CLOCK_MONOTONIC, &ini);
+        for (int r = 0; r < repeticoes; r++)
+        {
+            replay(regs, n, 0);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &fim);
+        double ns = (fim.tv_sec - ini.tv_sec) * 1e9 + (fim.tv_nsec - ini.tv_nsec);
+        fprintf(stderr, "%zu amostras x %d: %.1f ns/amostra\n", amostras, repeticoes, ns / ((double)amostras * repeticoes));
+    }
+
+    free(regs);
+    return 0;
+}
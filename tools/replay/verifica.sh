@@ -0,0 +1,33 @@
+#!/bin/sh
+#
+# Copyright (c) 2022-present joaocarlosfr.
+#
+# SPDX-License-Identifier: MIT
+#
+# Teste de regressão do pipeline: compila o replay, processa o trace de referência
+# (amostras/estacao.bin: calibração do datasheet do BME280, 4 h de amostras a cada 60 s,
+# com um registro de recalibração no meio, que não pode recomeçar a tendência)
+# e compara o CSV com a saída esperada (amostras/estacao.csv).
+#
+# Uso:  tools/replay/verifica.sh              compara; sai com erro e mostra o diff se divergir
+#       tools/replay/verifica.sh --atualiza   regrava a saída esperada após uma mudança intencional
+
+set -e
+
+dir=$(cd "$(dirname "$0")" && pwd)
+raiz=$(cd "$dir/../.." && pwd)
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+gcc -O2 -I"$raiz/main" "$dir/replay.c" "$raiz/main/processamento.c" "$raiz/main/tendencia.c" -lm -o "$tmp/replay"
+"$tmp/replay" "$dir/amostras/estacao.bin" > "$tmp/estacao.csv"
+
+if [ "$1" = "--atualiza" ]
+then
+    cp "$tmp/estacao.csv" "$dir/amostras/estacao.csv"
+    echo "replay: referência atualizada"
+    exit 0
+fi
+
+diff -u "$dir/amostras/estacao.csv" "$tmp/estacao.csv"
+echo "replay: saída igual à referência ($(($(wc -l < "$tmp/estacao.csv") - 1)) amostras)"
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @brief Decodificador no host dos eventos de tempestade publicados em topic/tempestade.
+ * 
+ * Lê um bloco por linha, em hexadecimal (formato %x do mosquitto_sub), decodifica com o
+ * mesmo código do firmware (main/tempestade_bloco.c) e imprime as amostras em CSV, com o
+ * índice de cada amostra no evento e se ela é anterior ao gatilho. Blocos repetidos
+ * (reentrega QoS1) são ignorados; blocos faltando são avisados em stderr.
+ * 
+ * Compilação:  gcc -O2 -Imain tools/tempestade/decodifica.c main/tempestade_bloco.c -o decodifica
+ * Uso:         mosquitto_sub -t topic/tempestade -F '%x' | ./decodifica
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "tempestade_bloco.h"
+
+#define TAM_BLOCO_MAX 1024      // Maior CONFIG_MQTT_MENSAGEM_MAX
+
+/**
+ * @brief Converte uma linha hexadecimal em bytes.
+ *
+ * @return quantidade de bytes, ou -1 se a linha não for hexadecimal válido
+ */
+static int le_hex(const char *linha, uint8_t *bloco, size_t max)
+{
+   size_t n = 0;
+   unsigned byte;
+   while (isxdigit((unsigned char)linha[0]) && isxdigit((unsigned char)linha[1]))
+   {
+      if (n == max || sscanf(linha, "%2x", &byte) != 1)
+      {
+         return -1;
+      }
+      bloco[n++] = (uint8_t)byte;
+      linha += 2;
+   }
+   return (linha[0] == '\0' || linha[0] == '\n' || linha[0] == '\r') ? (int)n : -1;
+}
+
+int main(void)
+{
+   static char linha[2 * TAM_BLOCO_MAX + 8];
+   static uint8_t bloco[TAM_BLOCO_MAX];
+   static tempestade_amostra_t amostras[TAM_BLOCO_MAX / 5];
+   tempestade_cabecalho_t cab;
+   int evento = -1, erros = 0;
+   unsigned proximo_seq = 0, indice = 0;
+   bool completo = false;          // Último bloco do evento já recebido
+   bool descartando = false;       // Faltou um bloco: o índice no evento é desconhecido
+
+   printf("evento,motivo,indice,pre_gatilho,tempo_ms,pressao_pa,temperatura_cc,umidade_c,chuva\n");
+   while (fgets(linha, sizeof(linha), stdin) != NULL)
+   {
+      int tamanho = le_hex(linha, bloco, sizeof(bloco));
+      int qtd = tamanho < 0 ? -1 : tempestade_bloco_decodifica(bloco, tamanho, &cab, amostras, sizeof(amostras) / sizeof(amostras[0]));
+      if (qtd < 0)
+      {
+         fprintf(stderr, "bloco invalido: %s", linha);
+         erros++;
+         continue;
+      }
+      if (cab.evento_id != evento || (completo && cab.seq == 0))
+      {
+         if (evento >= 0 && !completo)
+         {
+            fprintf(stderr, "evento %d: sem o ultimo bloco\n", evento);
+            erros++;
+         }
+         evento = cab.evento_id;
+         proximo_seq = 0;
+         indice = 0;
+         completo = false;
+         descartando = false;
+      }
+      if (completo || cab.seq < proximo_seq)
+      {
+         continue;                                  // Reentrega QoS1
+      }
+      if (cab.seq > proximo_seq)
+      {
+         fprintf(stderr, "evento %d: blocos %u a %u faltando, resto do evento ignorado\n", evento, proximo_seq, cab.seq - 1u);
+         erros++;
+         descartando = true;
+      }
+      proximo_seq = cab.seq + 1u;
+      completo = (cab.flags & TEMPESTADE_BLOCO_ULTIMO) != 0;
+      if (descartando)
+      {
+         continue;
+      }
+      for (int i = 0; i < qtd; i++, indice++)
+      {
+         const tempestade_amostra_t *a = &amostras[i];
+         printf("%u,%u,%u,%d,%u,%d,%d,%u,%u\n", (unsigned)cab.evento_id, (unsigned)cab.motivo, indice, indice < cab.gatilho,
+                (unsigned)a->tempo_ms, (int)a->pabs_pa, (int)a->temp_cc, (unsigned)a->umid_c, (unsigned)a->chuva);
+      }
+   }
+   if (evento >= 0 && !completo)
+   {
+      fprintf(stderr, "evento %d: sem o ultimo bloco\n", evento);
+      erros++;
+   }
+   return erros == 0 ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @brief Teste de ida e volta no host do formato dos blocos de tempestade (main/tempestade_bloco.c).
+ * 
+ * Para cada cenário de evento e cada tamanho de mensagem MQTT, divide o evento em blocos como
+ * a task de amostragem faz, decodifica cada bloco sozinho e confere que:
+ *  - a concatenação das amostras decodificadas é igual ao evento original;
+ *  - a sequência começa em 0 e é contínua, e só o último bloco tem a flag de último;
+ *  - id do evento, motivo e índice do gatilho se repetem em todos os blocos;
+ *  - nenhum bloco passa do tamanho da mensagem.
+ * Confere também que blocos truncados, com bytes sobrando ou de outra versão são rejeitados.
+ * 
+ * Compilação:  gcc -O2 -Imain tools/tempestade/verifica.c main/tempestade_bloco.c -o verifica_tempestade
+ * Uso:         ./verifica_tempestade
+ *              sai com 1 se algum cenário divergir
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tempestade_bloco.h"
+
+#define MAX_AMOSTRAS 2048
+#define MAX_BLOCO 1024
+
+static const size_t tamanhos[] = { TEMPESTADE_BLOCO_CABECALHO + TEMPESTADE_BLOCO_MAX_AMOSTRA, 64, 200, MAX_BLOCO };
+
+static tempestade_amostra_t evento[MAX_AMOSTRAS];
+static tempestade_amostra_t decodificado[MAX_AMOSTRAS];
+static tempestade_amostra_t rascunho[MAX_AMOSTRAS];       // Destino dos blocos que devem ser rejeitados
+static uint32_t semente = 12345;
+
+/**
+ * @brief Gerador congruente linear, para cenários reproduzíveis.
+ * 
+ */
+static uint32_t aleatorio(void)
+{
+   semente = semente * 1664525u + 1013904223u;
+   return semente >> 8;
+}
+
+/**
+ * @brief Evento típico: histórico de vigia a cada 10 s e rajada a cada 1 s, variações pequenas.
+ * 
+ */
+static size_t cenario_tipico(void)
+{
+   size_t n = 0;
+   tempestade_amostra_t a = { .tempo_ms = 3600000, .pabs_pa = 101325, .temp_cc = 2350, .umid_c = 6500, .chuva = 1000 };
+   for (; n < 128 + 600; n++)
+   {
+      a.tempo_ms += (n < 128) ? 10000 : 1000;
+      a.pabs_pa += (int32_t)(aleatorio() % 41) - 20;
+      a.temp_cc += (int16_t)(aleatorio() % 7) - 3;
+      a.umid_c += (aleatorio() % 11) - 5;
+      a.chuva = (n < 128) ? 1000 + aleatorio() % 4 : 300 + aleatorio() % 50;
+      evento[n] = a;
+   }
+   return n;
+}
+
+/**
+ * @brief Extremos de cada campo, com o relógio passando por 2^32 ms.
+ * 
+ */
+static size_t cenario_extremos(void)
+{
+   size_t n = 0;
+   for (; n < 300; n++)
+   {
+      tempestade_amostra_t a = {
+         .tempo_ms = UINT32_MAX - 150000 + (uint32_t)n * 1000,
+         .pabs_pa = (n & 1) ? INT32_MAX : INT32_MIN,
+         .temp_cc = (n & 2) ? INT16_MAX : INT16_MIN,
+         .umid_c = (n & 4) ? UINT16_MAX : 0,
+         .chuva = (n & 8) ? UINT16_MAX : 0,
+      };
+      evento[n] = a;
+   }
+   return n;
+}
+
+/**
+ * @brief Valores aleatórios em toda a faixa de cada campo.
+ * 
+ */
+static size_t cenario_aleatorio(void)
+{
+   size_t n = 0;
+   for (; n < MAX_AMOSTRAS; n++)
+   {
+      tempestade_amostra_t a = {
+         .tempo_ms = aleatorio() << 8 | (aleatorio() & 0xFF),
+         .pabs_pa = (int32_t)(aleatorio() << 8 | (aleatorio() & 0xFF)),
+         .temp_cc = (int16_t)aleatorio(),
+         .umid_c = (uint16_t)aleatorio(),
+         .chuva = (uint16_t)aleatorio(),
+      };
+      evento[n] = a;
+   }
+   return n;
+}
+
+static size_t cenario_unico(void)
+{
+   tempestade_amostra_t a = { .tempo_ms = 5000, .pabs_pa = 90000, .temp_cc = -1200, .umid_c = 10000, .chuva = 1023 };
+   evento[0] = a;
+   return 1;
+}
+
+static int iguais(const tempestade_amostra_t *a, const tempestade_amostra_t *b)
+{
+   return a->tempo_ms == b->tempo_ms && a->pabs_pa == b->pabs_pa && a->temp_cc == b->temp_cc &&
+          a->umid_c == b->umid_c && a->chuva == b->chuva;
+}
+
+/**
+ * @brief Divide o evento em blocos de até tamanho bytes e confere a volta.
+ * 
+ * @return quantidade de divergências
+ */
+static int verifica(const char *nome, size_t qtd, size_t tamanho)
+{
+   static uint8_t bloco[MAX_BLOCO];
+   tempestade_cabecalho_t cab, lido;
+   size_t enviadas = 0, recebidas = 0;
+   uint16_t seq = 0;
+   uint16_t gatilho = (uint16_t)(qtd / 5);
+
+   while (enviadas < qtd)
+   {
+      cab.evento_id = 42;
+      cab.seq = seq;
+      cab.motivo = 2;
+      cab.gatilho = gatilho;
+      size_t n = tempestade_bloco_codifica(bloco, tamanho, &evento[enviadas], qtd - enviadas, &cab);
+      if (n > tamanho || cab.qtd == 0)
+      {
+         printf("%s/%zu: bloco %u com %zu bytes e %u amostras\n", nome, tamanho, seq, n, cab.qtd);
+         return 1;
+      }
+      enviadas += cab.qtd;
+
+      int m = tempestade_bloco_decodifica(bloco, n, &lido, &decodificado[recebidas], MAX_AMOSTRAS - recebidas);
+      if (m != cab.qtd || lido.seq != seq || lido.evento_id != 42 || lido.motivo != 2 || lido.gatilho != gatilho ||
+          ((lido.flags & TEMPESTADE_BLOCO_ULTIMO) != 0) != (enviadas == qtd))
+      {
+         printf("%s/%zu: bloco %u decodificado com %d amostras, cabecalho divergente\n", nome, tamanho, seq, m);
+         return 1;
+      }
+      if (tempestade_bloco_decodifica(bloco, n - 1, &lido, rascunho, MAX_AMOSTRAS) >= 0)
+      {
+         printf("%s/%zu: bloco %u truncado foi aceito\n", nome, tamanho, seq);
+         return 1;
+      }
+      recebidas += m;
+      seq++;
+   }
+
+   for (size_t i = 0; i < qtd; i++)
+   {
+      if (!iguais(&evento[i], &decodificado[i]))
+      {
+         printf("%s/%zu: amostra %zu divergente\n", nome, tamanho, i);
+         return 1;
+      }
+   }
+   printf("%s/%zu: ok (%zu amostras em %u blocos)\n", nome, tamanho, qtd, seq);
+   return 0;
+}
+
+/**
+ * @brief Blocos malformados devem ser rejeitados.
+ * 
+ * @return quantidade de divergências
+ */
+static int verifica_rejeicao(void)
+{
+   uint8_t bloco[64];
+   tempestade_cabecalho_t cab = { .evento_id = 1 };
+   int erros = 0;
+   size_t n = tempestade_bloco_codifica(bloco, sizeof(bloco) - 1, evento, 1, &cab);
+
+   bloco[n] = 0;
+   if (tempestade_bloco_decodifica(bloco, n + 1, &cab, rascunho, MAX_AMOSTRAS) >= 0)
+   {
+      printf("bloco com byte sobrando foi aceito\n");
+      erros++;
+   }
+   bloco[0] = TEMPESTADE_BLOCO_VERSAO + 1;
+   if (tempestade_bloco_decodifica(bloco, n, &cab, rascunho, MAX_AMOSTRAS) >= 0)
+   {
+      printf("bloco de outra versao foi aceito\n");
+      erros++;
+   }
+   bloco[0] = TEMPESTADE_BLOCO_VERSAO;
+   if (tempestade_bloco_decodifica(bloco, n, &cab, rascunho, 0) >= 0)
+   {
+      printf("bloco maior que o destino foi aceito\n");
+      erros++;
+   }
+   return erros;
+}
+
+int main(void)
+{
+   static const struct {
+      const char *nome;
+      size_t (*gera)(void);
+   } cenarios[] = {
+      { "tipico", cenario_tipico },
+      { "extremos", cenario_extremos },
+      { "aleatorio", cenario_aleatorio },
+      { "unico", cenario_unico },
+   };
+   int erros = 0;
+
+   for (size_t c = 0; c < sizeof(cenarios) / sizeof(cenarios[0]); c++)
+   {
+      size_t qtd = cenarios[c].gera();
+      for (size_t t = 0; t < sizeof(tamanhos) / sizeof(tamanhos[0]); t++)
+      {
+         erros += verifica(cenarios[c].nome, qtd, tamanhos[t]);
+      }
+   }
+   erros += verifica_rejeicao();
+
+   printf("%d divergencias\n", erros);
+   return erros == 0 ? 0 : 1;
+}
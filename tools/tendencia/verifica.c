@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2022-present joaocarlosfr. 
+ * 
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @brief Teste no host da tendência barométrica (main/tendencia.c) contra séries de referência.
+ * 
+ * Para cada cenário de serie.csv (pressão e temperatura a cada minuto), alimenta a tendência
+ * amostra por amostra e:
+ *  - compara as inclinações O(1) de 1 h e 3 h com uma regressão de força bruta sobre a mesma
+ *    janela, em todas as amostras com a janela cheia;
+ *  - na última amostra, compara a variação em 3 h, o código WMO e a letra de Zambretti com
+ *    esperado.csv (valores de referência calculados fora do firmware).
+ * 
+ * Compilação:  gcc -O2 -Imain tools/tendencia/verifica.c main/tendencia.c -lm -o verifica_tendencia
+ * Uso:         ./verifica_tendencia tools/tendencia/serie.csv tools/tendencia/esperado.csv
+ *              sai com 1 se algum cenário divergir
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "tendencia.h"
+
+#define MAX_AMOSTRAS 1024
+#define TOLERANCIA_INCLINACAO 1e-4     // hPa/h, O(1) contra força bruta
+#define TOLERANCIA_VARIACAO 0.01       // hPa, contra o esperado (arredondado em 2 casas)
+
+typedef struct {
+   char nome[32];
+   int altitude_m;
+   size_t n;
+   int32_t pabs_pa[MAX_AMOSTRAS];
+   int32_t temp_cc[MAX_AMOSTRAS];
+} cenario_t;
+
+/**
+ * @brief Inclinação de mínimos quadrados por força bruta, em hPa/h.
+ * 
+ */
+static double inclinacao_bruta(const int32_t *y, size_t n)
+{
+   double xm = (n - 1) / 2.0, ym = 0, num = 0, den = 0;
+   for (size_t i = 0; i < n; i++)
+   {
+      ym += y[i];
+   }
+   ym /= n;
+   for (size_t i = 0; i < n; i++)
+   {
+      num += (i - xm) * (y[i] - ym);
+      den += (i - xm) * (i - xm);
+   }
+   return num / den * TENDENCIA_AMOSTRAS_HORA / 100;
+}
+
+/**
+ * @brief Procura o resultado esperado do cenário.
+ * 
+ * @return 0 se encontrado
+ */
+static int le_esperado(FILE *f, const char *nome, float *variacao, int *wmo, char *previsao)
+{
+   char linha[128], cenario[32];
+   rewind(f);
+   while (fgets(linha, sizeof(linha), f) != NULL)
+   {
+      if (linha[0] != '#' && sscanf(linha, "%31[^,],%f,%d,%c", cenario, variacao, wmo, previsao) == 4 &&
+          strcmp(cenario, nome) == 0)
+      {
+         return 0;
+      }
+   }
+   return -1;
+}
+
+/**
+ * @brief Roda um cenário completo.
+ * 
+ * @return quantidade de divergências
+ */
+static int verifica(const cenario_t *c, FILE *esperado)
+{
+   static tendencia_t tend;
+   float i1, i3, variacao_esperada;
+   int wmo_esperado, erros = 0;
+   char previsao_esperada;
+
+   tendencia_inicia(&tend);
+   for (size_t k = 0; k < c->n; k++)
+   {
+      tendencia_adiciona(&tend, c->pabs_pa[k]);
+      if (k + 1 >= TENDENCIA_N1 && tendencia_inclinacao(&tend, 1, &i1) &&
+          fabs(i1 - inclinacao_bruta(&c->pabs_pa[k + 1 - TENDENCIA_N1], TENDENCIA_N1)) > TOLERANCIA_INCLINACAO)
+      {
+         printf("%s: amostra %zu, inclinacao 1 h %.6f difere da forca bruta\n", c->nome, k, i1);
+         return erros + 1;
+      }
+      if (k + 1 >= TENDENCIA_N3 && tendencia_inclinacao(&tend, 3, &i3) &&
+          fabs(i3 - inclinacao_bruta(&c->pabs_pa[k + 1 - TENDENCIA_N3], TENDENCIA_N3)) > TOLERANCIA_INCLINACAO)
+      {
+         printf("%s: amostra %zu, inclinacao 3 h %.6f difere da forca bruta\n", c->nome, k, i3);
+         return erros + 1;
+      }
+   }
+
+   if (le_esperado(esperado, c->nome, &variacao_esperada, &wmo_esperado, &previsao_esperada) != 0)
+   {
+      printf("%s: sem resultado esperado\n", c->nome);
+      return 1;
+   }
+   if (!tendencia_inclinacao(&tend, 3, &i3))
+   {
+      printf("%s: menos de 3 h de amostras\n", c->nome);
+      return 1;
+   }
+   int wmo = tendencia_codigo_wmo(&tend);
+   float p0 = tendencia_nivel_mar(c->pabs_pa[c->n - 1] / 100.0f, c->temp_cc[c->n - 1] / 100.0f, c->altitude_m);
+   char previsao = tendencia_zambretti(p0, i3 * 3);
+   if (fabs(i3 * 3 - variacao_esperada) > TOLERANCIA_VARIACAO)
+   {
+      printf("%s: variacao 3 h %.2f, esperado %.2f\n", c->nome, i3 * 3, variacao_esperada);
+      erros++;
+   }
+   if (wmo != wmo_esperado)
+   {
+      printf("%s: codigo WMO %d, esperado %d\n", c->nome, wmo, wmo_esperado);
+      erros++;
+   }
+   if (previsao != previsao_esperada)
+   {
+      printf("%s: previsao %c, esperado %c\n", c->nome, previsao, previsao_esperada);
+      erros++;
+   }
+   if (erros == 0)
+   {
+      printf("%s: ok (%zu amostras, variacao %.2f hPa, WMO %d, Zambretti %c)\n", c->nome, c->n, i3 * 3, wmo, previsao);
+   }
+   return erros;
+}
+
+int main(int argc, char **argv)
+{
+   if (argc < 3)
+   {
+      fprintf(stderr, "uso: %s serie.csv esperado.csv\n", argv[0]);
+      return 1;
+   }
+   FILE *serie = fopen(argv[1], "r");
+   FILE *esperado = fopen(argv[2], "r");
+   if (serie == NULL || esperado == NULL)
+   {
+      perror(serie == NULL ? argv[1] : argv[2]);
+      return 1;
+   }
+
+   static cenario_t c;
+   char linha[128], nome[32];
+   int altitude, minuto, cenarios = 0, erros = 0;
+   long pabs, temp;
+   c.n = 0;
+   while (fgets(linha, sizeof(linha), serie) != NULL)
+   {
+      if (linha[0] == '#' || sscanf(linha, "%31[^,],%d,%d,%ld,%ld", nome, &altitude, &minuto, &pabs, &temp) != 5)
+      {
+         continue;
+      }
+      if (c.n > 0 && strcmp(nome, c.nome) != 0)
+      {
+         erros += verifica(&c, esperado);
+         cenarios++;
+         c.n = 0;
+      }
+      if (c.n == MAX_AMOSTRAS)
+      {
+         fprintf(stderr, "%s: mais de %d amostras\n", nome, MAX_AMOSTRAS);
+         return 1;
+      }
+      strcpy(c.nome, nome);
+      c.altitude_m = altitude;
+      c.pabs_pa[c.n] = pabs;
+      c.temp_cc[c.n] = temp;
+      c.n++;
+   }
+   if (c.n > 0)
+   {
+      erros += verifica(&c, esperado);
+      cenarios++;
+   }
+   fclose(serie);
+   fclose(esperado);
+
+   printf("%d cenarios, %d divergencias\n", cenarios, erros);
+   return erros == 0 && cenarios > 0 ? 0 : 1;
+}